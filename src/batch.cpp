@@ -0,0 +1,364 @@
+#ifdef HEADLESS
+
+#include <fstream>
+#include <sstream>
+#include <deque>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+#include "batch.h"
+#include "system.h"
+
+
+
+namespace fs = std::filesystem;
+
+
+namespace Batch {
+
+
+// A minimal work-stealing pool for a fixed set of (coarse) tasks: each worker
+// takes tasks from the back of its own queue, and when that runs dry, steals
+// from the front of the others.
+class Pool {
+public:
+    using Task = std::function<void ()>;
+
+    Pool(int worker_count) : queues(worker_count) {}
+
+    void run(std::vector<Task>&& tasks) {
+        const int wc = queues.size();
+
+        for (std::size_t t = 0; t < tasks.size(); ++t) {
+            queues[t % wc].tasks.push_back(std::move(tasks[t]));
+        }
+
+        std::vector<std::thread> workers;
+        for (int w = 0; w < wc; ++w) workers.emplace_back([this, w]() { work(w); });
+        for (auto& worker : workers) worker.join();
+    }
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<Queue> queues;
+
+    bool take(int w, Task& task) {
+        auto& q = queues[w];
+        std::lock_guard<std::mutex> lg(q.lock);
+        if (q.tasks.empty()) return false;
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(int w, Task& task) {
+        const int wc = queues.size();
+        for (int v = (w + 1) % wc; v != w; v = (v + 1) % wc) {
+            auto& q = queues[v];
+            std::lock_guard<std::mutex> lg(q.lock);
+            if (!q.tasks.empty()) {
+                task = std::move(q.tasks.front());
+                q.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(int w) {
+        // no tasks are added while running --> all done once there is nothing to steal
+        for (Task task; take(w, task) || steal(w, task); ) task();
+    }
+};
+
+
+static u64 fnv1a(const u8* data, std::size_t sz) {
+    u64 h = 0xcbf29ce484222325;
+    for (std::size_t b = 0; b < sz; ++b) h = (h ^ data[b]) * 0x100000001b3;
+    return h;
+}
+
+
+static std::string hex(u64 v) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)v);
+    return buf;
+}
+
+
+static std::string json_str(const std::string& s) { // quoted & escaped
+    std::string q = "\"";
+    for (const char c : s) {
+        if (c == '"' || c == '\\') {
+            q += '\\';
+            q += c;
+        } else if (u8(c) < 0x20) {
+            char buf[7];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            q += buf;
+        } else {
+            q += c;
+        }
+    }
+    return q + '"';
+}
+
+
+static const char* exit_str(Result::Exit e) {
+    using Exit = Result::Exit;
+    switch (e) {
+        case Exit::none:   return "none";
+        case Exit::budget: return "budget";
+        case Exit::halt:   return "halt";
+        case Exit::mem:    return "mem";
+        case Exit::error:  return "error";
+    }
+    return "?";
+}
+
+
+std::vector<Job> read_jobs(const std::string& job_list_path) {
+    std::vector<Job> jobs;
+
+    std::ifstream f(job_list_path);
+    if (!f) {
+        Log::error("Unable to open job list: '%s'", job_list_path.c_str());
+        return jobs;
+    }
+
+    auto parse = [](const std::string& line, Job& job) -> bool {
+        std::istringstream ls(line);
+        ls >> job.name;
+
+        for (std::string kv; ls >> kv; ) {
+            const auto eq = kv.find('=');
+            if (eq == std::string::npos) return false;
+            const auto key = kv.substr(0, eq);
+            const auto val = kv.substr(eq + 1);
+
+            try {
+                if (key == "cycles")      job.cycles = std::stoull(val);
+                else if (key == "file")   job.file = val;
+                else if (key == "prg")    job.prg = val;
+                else if (key == "boot")   job.boot_frames = std::stoull(val);
+                else if (key == "script") job.script = val;
+                else if (key == "audio")  job.audio = (val == "1");
+                else if (key == "drive")  job.drive = (val == "1");
+                else if (key == "until") {
+                    if (val == "halt") {
+                        job.until_halt = true;
+                    } else {
+                        const auto colon = val.find(':');
+                        if (colon == std::string::npos) return false;
+                        job.until_mem = std::make_pair(
+                            u16(std::stoul(val.substr(0, colon), nullptr, 16)),
+                            u8(std::stoul(val.substr(colon + 1), nullptr, 16)));
+                    }
+                }
+                else return false;
+            } catch (...) {
+                return false;
+            }
+        }
+
+        return job.cycles > 0;
+    };
+
+    std::set<std::string> names;
+    int line_n = 0;
+    for (std::string line; std::getline(f, line); ) {
+        ++line_n;
+        std::istringstream ls(line);
+        std::string first;
+        if (!(ls >> first) || first[0] == '#') continue;
+
+        Job job;
+        if (!parse(line, job)) {
+            Log::error("%s:%d: invalid job: '%s'", job_list_path.c_str(), line_n, line.c_str());
+        } else if (job.name.find_first_of("/\\:") != std::string::npos) { // (outputs go to 'out_dir')
+            Log::error("%s:%d: invalid job name: '%s'", job_list_path.c_str(), line_n, job.name.c_str());
+        } else if (!names.insert(job.name).second) {
+            Log::error("%s:%d: duplicate job name: '%s'", job_list_path.c_str(), line_n, job.name.c_str());
+        } else {
+            jobs.push_back(job);
+        }
+    }
+
+    return jobs;
+}
+
+
+static void inject_prg(State::System& s, const Bytes& prg) {
+    const u16 load_addr = prg[0] | (prg[1] << 8);
+
+    u32 addr = load_addr;
+    for (u32 b = 2; b < prg.size() && addr <= 0xffff; ++b) s.ram[addr++] = prg[b];
+
+    if (load_addr == 0x0801) { // basic program --> set the basic end pointers
+        for (u16 ptr : { 0x2d, 0x2f, 0x31, 0xae }) {
+            s.ram[ptr] = addr;
+            s.ram[ptr + 1] = addr >> 8;
+        }
+    }
+}
+
+
+static Result run_job(const Job& job, const std::string& out_dir, const State::System::ROM& roms) {
+    Result res;
+
+    Timer wall;
+
+    Maybe<Bytes> prg;
+    if (!job.prg.empty()) {
+        prg = read_file(job.prg);
+        if (!prg || prg->size() < 3) {
+            Log::error("%s: unable to read '%s'", job.name.c_str(), job.prg.c_str());
+            res.exit = Result::Exit::error;
+            return res;
+        }
+    }
+
+    System::C64 c64(roms);
+    if (!job.drive) c64.drive_power(false);
+
+    auto& input = c64.input();
+
+    if (!job.script.empty() && !input.load_script(job.script)) {
+        res.exit = Result::Exit::error;
+        return res;
+    }
+    if (!job.file.empty()) {
+        input.push({0, Host::Input::Event::drop, Key_code::System::nop, false, job.file});
+    }
+
+    std::vector<i16> audio;
+    if (job.audio) c64.audio_out().capture = &audio;
+
+    u64 frame = 0;
+    c64.frame_hook = [&](State::System& s) -> bool {
+        ++frame;
+
+        if (prg && frame == job.boot_frames) {
+            inject_prg(s, *prg);
+            if (((*prg)[0] | ((*prg)[1] << 8)) == 0x0801) input.type(s.vic.cycle, "run\n");
+        }
+
+        if (job.until_halt && s.cpu.opc() == MOS6502::OPC::halt) {
+            res.exit = Result::Exit::halt;
+            return false;
+        }
+        if (job.until_mem && s.ram[job.until_mem->first] == job.until_mem->second) {
+            res.exit = Result::Exit::mem;
+            return false;
+        }
+        if (s.vic.cycle >= job.cycles) {
+            res.exit = Result::Exit::budget;
+            return false;
+        }
+
+        return true;
+    };
+
+    c64.run(System::C64::Mode::headless);
+
+    const auto& s = c64.state();
+
+    res.cycles = s.vic.cycle;
+    res.frame_hash = fnv1a(s.vic.frame, VIC_II::FRAME_SIZE);
+    res.ram_hash = fnv1a(s.ram, sizeof(s.ram));
+    res.wall_ms = wall.elapsed() / 1000.0;
+
+    const auto out = fs::path(out_dir) / job.name;
+
+    if (auto f = std::ofstream(out.string() + ".ram", std::ios::binary)) {
+        f.write((const char*)s.ram, sizeof(s.ram));
+    }
+    if (job.audio) {
+        if (auto f = std::ofstream(out.string() + ".pcm", std::ios::binary)) {
+            f.write((const char*)audio.data(), audio.size() * sizeof(i16));
+        }
+    }
+
+    return res;
+}
+
+
+int run(const std::string& job_list_path, const std::string& out_dir,
+            const State::System::ROM& roms, int thread_count)
+{
+    const auto jobs = read_jobs(job_list_path);
+    if (jobs.empty()) {
+        Log::error("No jobs");
+        return 1;
+    }
+
+    try {
+        fs::create_directories(out_dir);
+    } catch (const fs::filesystem_error& e) {
+        Log::error("%s", e.what());
+        return 1;
+    }
+
+    if (thread_count <= 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+    thread_count = std::min<int>(thread_count, jobs.size());
+
+    // reSID initializes its (static) tables lazily on first construction --> do it
+    // here, before going multi-threaded
+    { reSID::SID warm_up; }
+
+    Log::info("Batch: %d jobs, %d threads", int(jobs.size()), thread_count);
+
+    Timer wall;
+
+    std::vector<Result> results(jobs.size());
+    std::atomic<int> done{0};
+
+    std::vector<Pool::Task> tasks;
+    for (std::size_t j = 0; j < jobs.size(); ++j) {
+        tasks.push_back([&, j]() {
+            results[j] = run_job(jobs[j], out_dir, roms);
+            Log::info("Batch: [%d/%d] %s: %s", ++done, int(jobs.size()),
+                        jobs[j].name.c_str(), exit_str(results[j].exit));
+        });
+    }
+
+    Pool(thread_count).run(std::move(tasks));
+
+    const double wall_ms = wall.elapsed() / 1000.0;
+
+    u64 total_cycles = 0;
+    int failed = 0;
+
+    std::ofstream f((fs::path(out_dir) / "results.json").string());
+    f << "[\n";
+    for (std::size_t j = 0; j < jobs.size(); ++j) {
+        const auto& r = results[j];
+        total_cycles += r.cycles;
+        if (r.exit == Result::Exit::error) ++failed;
+
+        f << "  {\"name\": " << json_str(jobs[j].name) << ", \"exit\": \"" << exit_str(r.exit)
+          << "\", \"cycles\": " << r.cycles
+          << ", \"frame_hash\": \"" << hex(r.frame_hash)
+          << "\", \"ram_hash\": \"" << hex(r.ram_hash)
+          << "\", \"wall_ms\": " << r.wall_ms << "}"
+          << ((j + 1) < jobs.size() ? ",\n" : "\n");
+    }
+    f << "]\n";
+
+    Log::info("Batch: done in %.1f s (%.2f Mcycles/s total)",
+                wall_ms / 1000.0, (total_cycles / 1e6) / (wall_ms / 1000.0));
+
+    return failed ? 1 : 0;
+}
+
+
+} // namespace Batch
+
+
+#endif // HEADLESS
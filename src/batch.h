@@ -0,0 +1,70 @@
+#ifndef BATCH_H_INCLUDED
+#define BATCH_H_INCLUDED
+
+#include <string>
+#include <vector>
+#include "common.h"
+#include "state.h"
+
+
+
+// Runs a list of jobs, each on its own headless C64 instance, spread over a pool of
+// worker threads (headless build only).
+namespace Batch {
+
+
+/*  Job list format (one job per line, '#' starts a comment):
+        <name> <key>=<value> ...
+
+    The names must be unique & may not contain path separators (they name the outputs).
+
+    keys:
+        cycles=<n>        cycle budget (required), a run ends at the first frame boundary >= n
+        file=<path>       crt/d64/g64/snapshot/input log, 'dropped' at frame 0
+        prg=<path>        injected to RAM at frame 'boot' (& 'RUN' typed, if loaded to $0801)
+        boot=<frames>     default: 150
+        script=<path>     input script (see 'host_headless.h')
+        until=halt        exit condition: CPU halted
+        until=<addr>:<val> exit condition: RAM[addr] == val (hex)
+        audio=1           capture audio
+        drive=0           1541 powered off (faster, if the job does not need it)
+
+    Outputs (to 'out_dir'):
+        <name>.ram        final RAM (64 KB)
+        <name>.pcm        audio (signed 16 bit, mono, 44.1 kHz), if captured
+        results.json      summary of all the jobs (exit reason, cycles, frame hash, ...)
+*/
+struct Job {
+    std::string name;
+    u64 cycles = 0;
+    std::string file;
+    std::string prg;
+    u64 boot_frames = 150;
+    std::string script;
+    bool until_halt = false;
+    Maybe<std::pair<u16, u8>> until_mem;
+    bool audio = false;
+    bool drive = true;
+};
+
+
+struct Result {
+    enum class Exit { none, budget, halt, mem, error };
+
+    Exit exit = Exit::none;
+    u64 cycles = 0;
+    u64 frame_hash = 0;
+    u64 ram_hash = 0;
+    double wall_ms = 0;
+};
+
+
+std::vector<Job> read_jobs(const std::string& job_list_path);
+
+int run(const std::string& job_list_path, const std::string& out_dir,
+            const State::System::ROM& roms, int thread_count = 0); // 0 --> hw concurrency
+
+
+} // namespace Batch
+
+#endif // BATCH_H_INCLUDED
@@ -0,0 +1,492 @@
+#ifdef BENCH
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include "bench.h"
+#include "system.h"
+
+
+
+namespace Bench {
+
+
+using Chip = System::C64::Chip;
+
+
+struct Config {
+    int repeats = 5;
+    u64 frames = 50; // per repeat
+    u64 chip_ticks = 10 * FRAME_CYCLE_COUNT; // per repeat (chips in isolation)
+};
+
+
+static u64 now_ns() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+
+template<typename F>
+static double time_ns(u64 n, F&& f) {
+    const auto t0 = now_ns();
+    for (u64 i = 0; i < n; ++i) f();
+    return double(now_ns() - t0);
+}
+
+
+// xorshift (for 'random' but reproducible memory contents)
+static void fill(u8* mem, std::size_t sz, u32 seed) {
+    for (std::size_t b = 0; b < sz; ++b) {
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+        mem[b] = seed;
+    }
+}
+
+
+Stats Stats::of(std::vector<double> samples) {
+    if (samples.empty()) return {};
+
+    std::sort(samples.begin(), samples.end());
+
+    const auto n = samples.size();
+    const double median = (n % 2) ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+
+    return { samples.front(), median, samples.back() };
+}
+
+
+static Result cpu_bare(const Config& cfg) {
+    using namespace MOS6502;
+
+    auto mem = std::make_unique<u8[]>(0x10000);
+    fill(mem.get(), 0x10000, 0x6502);
+
+    // a mix of addressing modes, loads/stores, arithmetic & branches
+    static const u8 prg[] = {
+        0xa2, 0x00,             // 0200: ldx #$00
+        0xbd, 0x00, 0x10,       // 0202: lda $1000,x
+        0x7d, 0x00, 0x11,       // 0205: adc $1100,x
+        0x9d, 0x00, 0x12,       // 0208: sta $1200,x
+        0xb1, 0xfb,             // 020b: lda ($fb),y
+        0x49, 0x5a,             // 020d: eor #$5a
+        0x91, 0xfb,             // 020f: sta ($fb),y
+        0xc8,                   // 0211: iny
+        0xe6, 0x02,             // 0212: inc $02
+        0xe8,                   // 0214: inx
+        0xd0, 0xeb,             // 0215: bne $0202
+        0x4c, 0x00, 0x02,       // 0217: jmp $0200
+    };
+    std::copy(std::begin(prg), std::end(prg), &mem[0x0200]);
+    mem[0xfb] = 0x00; mem[0xfc] = 0x13;
+    mem[0xfffc] = 0x00; mem[0xfffd] = 0x02;
+
+    Core::State cpu_state;
+    Sig_halt sig_halt = [](u8 opc, u8 d) { Log::error("CPU halted (opc: %d, d: %d)", opc, d); };
+    Core cpu{cpu_state, sig_halt};
+    cpu.reset();
+
+    auto tick = [&]() {
+        if (cpu.s.bus.rw == Core::State::Bus::r) cpu.s.bus.d = mem[cpu.s.bus.a];
+        else mem[cpu.s.bus.a] = cpu.s.bus.d;
+        cpu.tick();
+    };
+
+    const u64 cycles = cfg.frames * FRAME_CYCLE_COUNT;
+
+    std::vector<double> cps, ns;
+    for (int r = 0; r < cfg.repeats; ++r) {
+        const double t = time_ns(cycles, tick);
+        cps.push_back(cycles * 1e9 / t);
+        ns.push_back(t / cycles);
+    }
+
+    return { "cpu_bare", cycles, Stats::of(cps), {{"cpu", Stats::of(ns)}} };
+}
+
+
+// Klaus Dormann's 6502 functional test, run until it traps (i.e. a full pass)
+static Maybe<Result> cpu_functional(const Config& cfg) {
+    using namespace MOS6502;
+
+    static const std::string path = "data/6502_functional_test/6502_functional_test.bin";
+    static constexpr u16 success_pc = 0x3469;
+
+    const auto bin = read_file(path);
+    if (!bin || (*bin).size() != 0x10000) {
+        Log::error("cpu_functional: '%s' not found (skipped)", path.c_str());
+        return std::nullopt;
+    }
+
+    auto mem = std::make_unique<u8[]>(0x10000);
+
+    Core::State cpu_state;
+    Sig_halt sig_halt = [](u8 opc, u8 d) { Log::error("CPU halted (opc: %d, d: %d)", opc, d); };
+    Core cpu{cpu_state, sig_halt};
+
+    auto tick = [&]() {
+        if (cpu.s.bus.rw == Core::State::Bus::r) cpu.s.bus.d = mem[cpu.s.bus.a];
+        else mem[cpu.s.bus.a] = cpu.s.bus.d;
+        cpu.tick();
+    };
+
+    u64 cycles = 0;
+    std::vector<double> cps, ns;
+    for (int r = 0; r < cfg.repeats; ++r) {
+        std::copy((*bin).begin(), (*bin).end(), mem.get());
+        mem[0xfffc] = 0x00; mem[0xfffd] = 0x04;
+        cpu.reset();
+
+        cycles = 0;
+        const auto t0 = now_ns();
+        for (u16 prev_a = 0x0000;; ++cycles) {
+            if (cpu.at_fetch()) {
+                if (cpu.s.bus.a == prev_a) break; // trapped (jmp *, or a branch to itself)
+                prev_a = cpu.s.bus.a;
+            }
+            tick();
+        }
+        const double t = double(now_ns() - t0);
+
+        if (cpu.s.bus.a != success_pc) {
+            Log::error("cpu_functional: trapped at %04x (failed)", cpu.s.bus.a);
+            return std::nullopt;
+        }
+
+        cps.push_back(cycles * 1e9 / t);
+        ns.push_back(t / cycles);
+    }
+
+    return Result{ "cpu_functional", cycles, Stats::of(cps), {{"cpu", Stats::of(ns)}} };
+}
+
+
+struct Machine {
+    std::string name;
+    std::vector<std::pair<u16, u8>> regs; // written at reset (VIC setup)
+    bool reu;
+    std::vector<Chip> chips; // timed in isolation
+};
+
+
+// A minimal 'kernal': writes the 'regs', and then runs a busy loop (or keeps the REU busy)
+static void build_kernal(u8* kernal, const Machine& m) {
+    static constexpr u16 kernal_start = 0xe000;
+
+    std::vector<u8> code;
+    auto emit = [&](std::initializer_list<u8> bytes) { code.insert(code.end(), bytes); };
+    auto poke = [&](u16 addr, u8 val) { emit({0xa9, val, 0x8d, u8(addr), u8(addr >> 8)}); };
+
+    emit({0x78}); // sei
+    poke(0x0001, 0x37); // port data first (as the kernal does), or the kernal gets banked out
+    poke(0x0000, 0x2f);
+    for (const auto& [addr, val] : m.regs) poke(addr, val);
+
+    const u16 loop = kernal_start + code.size();
+    if (m.reu) {
+        // 16 KB from $4000 --> REU, then the other way around
+        for (const u8 cmd : { 0x90, 0x91 }) {
+            poke(0xdf02, 0x00); poke(0xdf03, 0x40); // c64 addr
+            poke(0xdf04, 0x00); poke(0xdf05, 0x00); poke(0xdf06, 0x00); // reu addr
+            poke(0xdf07, 0x00); poke(0xdf08, 0x40); // length
+            poke(0xdf01, cmd); // exec, no $ff00 trigger
+        }
+    } else {
+        emit({
+            0xa2, 0x00,       // ldx #$00
+            0xbd, 0x00, 0x04, // lda $0400,x
+            0x69, 0x01,       // adc #$01
+            0x9d, 0x00, 0x04, // sta $0400,x
+            0xe8,             // inx
+            0xd0, 0xf5,       // bne (lda)
+        });
+    }
+    emit({0x4c, u8(loop), u8(loop >> 8)}); // jmp loop
+
+    const u16 rti = kernal_start + code.size();
+    emit({0x40});
+
+    std::copy(code.begin(), code.end(), kernal);
+
+    auto vector = [&](u16 addr, u16 to) {
+        kernal[addr - kernal_start] = to;
+        kernal[addr - kernal_start + 1] = to >> 8;
+    };
+    vector(0xfffa, rti);
+    vector(0xfffc, kernal_start);
+    vector(0xfffe, rti);
+}
+
+
+static double time_chip(System::C64& c64, Chip chip, u64 n) {
+    switch (chip) {
+        case Chip::cpu: return time_ns(n, [&]() { c64.tick_chip<Chip::cpu>(); });
+        case Chip::vic: return time_ns(n, [&]() { c64.tick_chip<Chip::vic>(); });
+        case Chip::cia: return time_ns(n, [&]() { c64.tick_chip<Chip::cia>(); });
+        case Chip::exp: return time_ns(n, [&]() { c64.tick_chip<Chip::exp>(); });
+    }
+    return 0;
+}
+
+
+static const char* chip_name(Chip chip) {
+    switch (chip) {
+        case Chip::cpu: return "cpu";
+        case Chip::vic: return "vic";
+        case Chip::cia: return "cia";
+        case Chip::exp: return "exp";
+    }
+    return "?";
+}
+
+
+static Result machine(const Machine& m, const Config& cfg) {
+    static constexpr u64 warm_up_frames = 10;
+
+    auto rom = std::make_unique<State::System::ROM>();
+    fill(rom->charr, sizeof(rom->charr), 0xc64);
+    build_kernal(rom->kernal, m);
+
+    System::C64 c64(*rom);
+    c64.drive_power(false);
+
+    State::System* sys = nullptr;
+    u64 frame = 0;
+    u64 t0 = 0;
+    u64 c0 = 0;
+    std::vector<double> cps;
+
+    c64.frame_hook = [&](State::System& s) -> bool {
+        if (frame++ == 0) {
+            sys = &s;
+            fill(s.ram + 0x0400, 0x10000 - 0x0400, 0x1234);
+            fill(s.color_ram, sizeof(s.color_ram), 0x5678);
+            if (m.reu) {
+                Expansion::attach_REU(s);
+                Expansion::reset(s);
+            }
+        }
+
+        if (frame == warm_up_frames) {
+            t0 = now_ns();
+            c0 = s.vic.cycle;
+        } else if (frame > warm_up_frames && ((frame - warm_up_frames) % cfg.frames) == 0) {
+            const auto t1 = now_ns();
+            cps.push_back((s.vic.cycle - c0) * 1e9 / (t1 - t0));
+            t0 = now_ns();
+            c0 = s.vic.cycle;
+        }
+
+        return int(cps.size()) < cfg.repeats;
+    };
+
+    c64.run(System::C64::Mode::headless);
+
+    Result res{m.name, cfg.frames * FRAME_CYCLE_COUNT, Stats::of(cps), {}};
+
+    const auto cps_median = res.cycles_per_sec.median;
+    res.ns_per_tick.push_back({"system", {1e9 / res.cycles_per_sec.max, 1e9 / cps_median,
+                                            1e9 / res.cycles_per_sec.min}});
+
+    // each chip on its own, always starting from the same state
+    const auto snapshot = std::make_unique<State::System>(*sys);
+    for (const auto chip : m.chips) {
+        std::vector<double> ns;
+        for (int r = 0; r < cfg.repeats; ++r) {
+            *sys = *snapshot;
+            ns.push_back(time_chip(c64, chip, cfg.chip_ticks) / cfg.chip_ticks);
+        }
+        res.ns_per_tick.push_back({chip_name(chip), Stats::of(ns)});
+    }
+
+    return res;
+}
+
+
+static Result sid(reSID::sampling_method method, const char* name, const Config& cfg) {
+    auto sid = std::make_unique<reSID::SID>();
+    sid->set_chip_model(reSID::MOS6581);
+    sid->set_sampling_parameters(CPU_FREQ_PAL, method, AUDIO_OUTPUT_FREQ);
+
+    static const u8 regs[][2] = {
+        // voice 1: saw, voice 2: pulse, voice 3: noise (all gates on)
+        {0x00, 0x00}, {0x01, 0x11}, {0x05, 0x09}, {0x06, 0xf0}, {0x04, 0x21},
+        {0x07, 0x00}, {0x08, 0x22}, {0x0a, 0x08}, {0x0c, 0x09}, {0x0d, 0xf0}, {0x0b, 0x41},
+        {0x0e, 0x00}, {0x0f, 0x33}, {0x13, 0x09}, {0x14, 0xf0}, {0x12, 0x81},
+        // filter: all voices, low pass, mid cutoff & resonance, full volume
+        {0x15, 0x00}, {0x16, 0x40}, {0x17, 0x87}, {0x18, 0x1f},
+    };
+    for (const auto& r : regs) sid->write(r[0], r[1]);
+
+    // clocked like 'reSID_Wrapper::tick()' does, a sync point worth of cycles at a time
+    static constexpr int chunk_cycles = FRAME_CYCLE_COUNT / 4;
+    std::vector<short> buf(AUDIO_OUTPUT_FREQ);
+
+    const u64 cycles = cfg.frames * FRAME_CYCLE_COUNT;
+
+    std::vector<double> cps, ns;
+    for (int r = 0; r < cfg.repeats; ++r) {
+        const double t = time_ns(cycles / chunk_cycles, [&]() {
+            for (reSID::cycle_count dt = chunk_cycles; dt > 0; ) sid->clock(dt, buf.data(), buf.size());
+        });
+        cps.push_back(cycles * 1e9 / t);
+        ns.push_back(t / cycles);
+    }
+
+    return { std::string("sid_") + name, cycles, Stats::of(cps), {{"sid", Stats::of(ns)}} };
+}
+
+
+static Result c1541_gcr(const Config& cfg) {
+    using PB = C1541::Disk_ctrl::PB;
+    using R = C1541::VIA::R;
+
+    auto st = std::make_unique<State::C1541>();
+    auto rom = std::make_unique<u8[]>(0x4000);
+    IO::Port::PD_in cia2_pa_in = [](u8 bits, u8 bit_vals) { UNUSED2(bits, bit_vals); };
+
+    C1541::System drive{*st, cia2_pa_in, rom.get()};
+    drive.reset();
+
+    const Bytes d64_data(std::size_t{Files::D64::size});
+    const C1541::D64 disk{Files::D64{d64_data}};
+    drive.dc.load_disk(&disk);
+
+    // motor on, max. bit rate, read mode & byte ready enabled (as the DOS would do)
+    drive.dc.via_w(R::ddrb, 0x6f);
+    drive.dc.via_w(R::rb, PB::motor | PB::led | PB::bit_rate);
+    drive.dc.via_w(R::pcr, 0xee);
+
+    const u64 cycles = cfg.frames * FRAME_CYCLE_COUNT;
+
+    std::vector<double> cps, ns;
+    for (int r = 0; r < cfg.repeats; ++r) {
+        const double t = time_ns(cycles, [&]() { drive.dc.tick(); });
+        cps.push_back(cycles * 1e9 / t);
+        ns.push_back(t / cycles);
+    }
+
+    return { "c1541_gcr", cycles, Stats::of(cps), {{"disk_ctrl", Stats::of(ns)}} };
+}
+
+
+static std::string to_json(const Stats& s) {
+    std::ostringstream o;
+    o << "{\"min\": " << s.min << ", \"median\": " << s.median << ", \"max\": " << s.max << "}";
+    return o.str();
+}
+
+
+static std::string to_json(const std::vector<Result>& results, const Config& cfg) {
+    std::ostringstream o;
+    o.precision(6);
+
+    o << "{\n  \"version\": \"" << __VERSION_INFO__ << "\",\n  \"repeats\": " << cfg.repeats
+      << ",\n  \"cpu_dispatch\": \"" << MOS6502::dispatch_backend() << "\""
+      << ",\n  \"vic_simd\": \"" << VIC_II::SIMD::backend() << "\""
+      << ",\n  \"scenarios\": [\n";
+    for (std::size_t r = 0; r < results.size(); ++r) {
+        const auto& res = results[r];
+        o << "    {\"name\": \"" << res.name << "\", \"cycles\": " << res.cycles
+          << ",\n     \"cycles_per_sec\": " << to_json(res.cycles_per_sec)
+          << ",\n     \"ns_per_tick\": {";
+        for (std::size_t c = 0; c < res.ns_per_tick.size(); ++c) {
+            o << (c ? ", " : "") << "\"" << res.ns_per_tick[c].first << "\": "
+              << to_json(res.ns_per_tick[c].second);
+        }
+        o << "}}" << ((r + 1) < results.size() ? ",\n" : "\n");
+    }
+    o << "  ]\n}\n";
+
+    return o.str();
+}
+
+
+int run(int argc, char** argv) {
+    Config cfg;
+    std::string out_path;
+    std::vector<std::string> only;
+
+    for (int a = 1; a < argc; ++a) {
+        const std::string arg = argv[a];
+        if (arg == "-r" && (a + 1) < argc) cfg.repeats = std::max(1, std::stoi(argv[++a]));
+        else if (arg == "-o" && (a + 1) < argc) out_path = argv[++a];
+        else if (arg[0] != '-') only.push_back(arg);
+        else {
+            Log::error("Unknown argument: '%s'", arg.c_str());
+            return 1;
+        }
+    }
+
+    auto selected = [&](const std::string& name) {
+        if (only.empty()) return true;
+        for (const auto& prefix : only) if (name.rfind(prefix, 0) == 0) return true;
+        return false;
+    };
+
+    const std::vector<Chip> vic_chips{Chip::cpu, Chip::vic, Chip::cia};
+
+    const std::vector<Machine> machines{
+        {"vic_blank",      {{0xd011, 0x0b}},                                   false, vic_chips},
+        {"vic_std_text",   {{0xd011, 0x1b}, {0xd016, 0x08}, {0xd018, 0x14}},   false, vic_chips},
+        {"vic_mc_text",    {{0xd011, 0x1b}, {0xd016, 0x18}, {0xd018, 0x14}},   false, vic_chips},
+        {"vic_ecm_text",   {{0xd011, 0x5b}, {0xd016, 0x08}, {0xd018, 0x14}},   false, vic_chips},
+        {"vic_std_bitmap", {{0xd011, 0x3b}, {0xd016, 0x08}, {0xd018, 0x18}},   false, vic_chips},
+        {"vic_mc_bitmap",  {{0xd011, 0x3b}, {0xd016, 0x18}, {0xd018, 0x18}},   false, vic_chips},
+        {"vic_sprites",    {{0xd011, 0x1b}, {0xd016, 0x08}, {0xd018, 0x14},
+                            {0xd015, 0xff}, {0xd01c, 0x0f}, {0xd017, 0xaa}, {0xd01d, 0x55},
+                            {0xd000, 0x20}, {0xd001, 0x40}, {0xd002, 0x38}, {0xd003, 0x50},
+                            {0xd004, 0x50}, {0xd005, 0x60}, {0xd006, 0x68}, {0xd007, 0x70},
+                            {0xd008, 0x80}, {0xd009, 0x80}, {0xd00a, 0x98}, {0xd00b, 0x90},
+                            {0xd00c, 0xb0}, {0xd00d, 0xa0}, {0xd00e, 0xc8}, {0xd00f, 0xb0}}, false, vic_chips},
+        {"reu_dma",        {{0xd011, 0x1b}},                                   true, {Chip::cpu, Chip::exp}},
+    };
+
+    std::vector<Result> results;
+    auto add = [&](const Result& res) {
+        Log::info("%-16s %8.2f Mcycles/s (median)", res.name.c_str(), res.cycles_per_sec.median / 1e6);
+        results.push_back(res);
+    };
+
+    if (selected("cpu_bare")) add(cpu_bare(cfg));
+    if (selected("cpu_functional")) {
+        if (const auto res = cpu_functional(cfg)) add(*res);
+    }
+
+    for (const auto& m : machines) if (selected(m.name) && m.name.rfind("vic_", 0) == 0) add(machine(m, cfg));
+
+    static const std::pair<reSID::sampling_method, const char*> sampling_methods[] = {
+        {reSID::SAMPLE_FAST, "fast"}, {reSID::SAMPLE_INTERPOLATE, "interpolate"},
+        {reSID::SAMPLE_RESAMPLE, "resample"}, {reSID::SAMPLE_RESAMPLE_FASTMEM, "resample_fastmem"},
+    };
+    for (const auto& [method, name] : sampling_methods) {
+        if (selected(std::string("sid_") + name)) add(sid(method, name, cfg));
+    }
+
+    if (selected("c1541_gcr")) add(c1541_gcr(cfg));
+
+    for (const auto& m : machines) if (selected(m.name) && m.reu) add(machine(m, cfg));
+
+    const auto json = to_json(results, cfg);
+
+    if (out_path.empty()) {
+        std::cout << json;
+    } else if (auto f = std::ofstream(out_path)) {
+        f << json;
+        Log::info("Results written to '%s'", out_path.c_str());
+    } else {
+        Log::error("Unable to write '%s'", out_path.c_str());
+        return 1;
+    }
+
+    return 0;
+}
+
+
+} // namespace Bench
+
+
+#endif // BENCH
@@ -0,0 +1,50 @@
+#ifndef BENCH_H_INCLUDED
+#define BENCH_H_INCLUDED
+
+#include <string>
+#include <vector>
+#include "common.h"
+
+
+
+// Reproducible performance scenarios (bench build only)
+namespace Bench {
+
+
+/*  Scenarios (self-contained, i.e. no ROMs needed):
+        cpu_bare          6502 core on a flat 64 KB RAM
+        cpu_functional    6502 core running the functional test (a full pass; the test binary
+                          is read from 'data/', i.e. run from the project root)
+        vic_<mode>        C64 running a busy loop, VIC in the given graphics mode
+        sid_<method>      reSID with all voices playing (filter on), for each sampling method
+        c1541_gcr         1541 disk controller reading a (GCR) track
+        reu_dma           C64 with REU doing back-to-back DMA transfers
+
+    For each scenario: emulated cycles/s, and ns per 'tick()' for each relevant chip
+    (timed in isolation), as min/median/max over the repeats. Output is JSON (on stdout,
+    unless a file is given; the log goes to stderr in the bench build).
+*/
+struct Stats {
+    double min = 0;
+    double median = 0;
+    double max = 0;
+
+    static Stats of(std::vector<double> samples);
+};
+
+
+struct Result {
+    std::string name;
+    u64 cycles = 0; // emulated, per repeat
+    Stats cycles_per_sec;
+    std::vector<std::pair<std::string, Stats>> ns_per_tick; // chip --> ns/tick
+};
+
+
+// usage: c64_emu_bench [-r <repeats>] [-o <json file>] [scenario name prefix...]
+int run(int argc, char** argv);
+
+
+} // namespace Bench
+
+#endif // BENCH_H_INCLUDED
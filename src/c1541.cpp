@@ -73,6 +73,13 @@ void C1541::IEC::update_iec_lines() {
         - Commodore 64 Programmers Reference Guide, Chapter 8 - Schematics
         - Commodore 1541 Troubleshooting and Repair Guide, Fig. 7-30 (p. 170..171)
     */
+    if (!connected) {
+        const pin_state clk = invert(cia2_pa(4)) & cia2_pa(6);
+        const pin_state data = invert(cia2_pa(5)) & cia2_pa(7);
+        cia2_pa_in(0b11000000, (data << 7) | (clk << 6));
+        return;
+    }
+
     const pin_state clk = invert(cia2_pa(4)) & cia2_pa(6) & invert(via_pb(3));
 
     const pin_state atn_now = cia2_pa(3) & via_pb(7); // pa3 inverted twice --> taken as such
@@ -160,10 +167,8 @@ void C1541::Disk_carousel::insert(int in_slot, const Disk_image* disk, const std
             Log::error("Carousel full (TODO)");
             return;
         }
-    } else if (slots[in_slot].disk) {
-        delete slots[in_slot].disk; // TODO: save changes...
-    }
-    slots[in_slot] = Slot{disk, name, true};
+    } // TODO: save changes (of the replaced disk)...
+    slots[in_slot] = Slot{std::shared_ptr<const Disk_image>(disk), name, true};
     select(in_slot);
 }
 
@@ -178,7 +183,7 @@ void C1541::Disk_carousel::rotate() {
 
 
 void C1541::Disk_carousel::load() {
-    disk_ctrl.load_disk(selected().disk);
+    disk_ctrl.load_disk(selected().disk.get());
     disk_ctrl.set_write_prot(selected().write_prot);
 
     Log::info("Disk selected: %s (slot %d)", selected().disk_name.c_str(), selected_slot);
@@ -198,6 +203,17 @@ void C1541::System::reset() {
 }
 
 
+void C1541::System::power(bool on) {
+    if (on == power_on) return;
+
+    power_on = on;
+    if (power_on) reset();
+    iec.connect(power_on);
+
+    Log::info("C1541 power: %s", power_on ? "on" : "off");
+}
+
+
 void C1541::System::tick() {
     bus_access();
     cpu.tick();
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <string>
+#include <memory>
 #include "common.h"
 #include "state.h"
 #include "utils.h"
@@ -172,7 +173,7 @@ public:
 
 class G64 : public Disk_image {
 public:
-    G64(std::vector<u8>&& data) : g64{std::move(data)} {}
+    G64(Blob data) : g64{std::move(data)} {}
     virtual ~G64() {}
     /* TODO:
         - validate image (here?), just return null tracks if invalid
@@ -256,8 +257,6 @@ public:
     virtual ~Null_disk() {}
 };
 
-static const Null_disk null_disk;
-
 
 namespace VIA {
 
@@ -449,6 +448,11 @@ public:
         update_iec_lines();
     }
 
+    void connect(bool c) { // 'disconnected' --> drive outputs released
+        connected = c;
+        update_iec_lines();
+    }
+
     void tick() { // TODO: extract T1 (+ T2 if ever needed) functionality
         if (--s.r_t1c == 0xffff) {
             s.r_t1c = s.r_t1l;
@@ -477,6 +481,8 @@ private:
 
     IO::Port::PD_in& cia2_pa_in;
 
+    bool connected = true;
+
     pin_state cia2_pa(int pin) const { return read_pin(s.cia2_pa_out, pin); }
     pin_state via_pb(int pin) const  { return read_pin(s.via_pb_out, pin); }
 
@@ -519,7 +525,10 @@ public:
     };
     const Status status{s.head, s.via_pb_out, s.via_pb_in};
 
-    Disk_ctrl(State& s_, CPU& cpu_) : s(s_), irq(s.irq), cpu(cpu_) { load_disk(&null_disk); }
+    Disk_ctrl(State& s_, CPU& cpu_) : s(s_), irq(s.irq), cpu(cpu_) {
+        const Null_disk no_disk;
+        load_disk(&no_disk);
+    }
 
     void reset();
 
@@ -713,7 +722,7 @@ public:
     static constexpr int slot_count = 0x100;
 
     struct Slot {
-        const Disk_image* disk = nullptr;
+        std::shared_ptr<const Disk_image> disk;
         std::string disk_name;
         bool write_prot;
     };
@@ -721,7 +730,7 @@ public:
     Disk_carousel(Disk_ctrl& disk_ctrl_, u8& dos_wp_change_flag_)
       : disk_ctrl(disk_ctrl_), dos_wp_change_flag(dos_wp_change_flag_)
     {
-        slots[0] = Slot{&null_disk, "<NO DISK>", false};
+        slots[0] = Slot{std::make_shared<const Null_disk>(), "<NO DISK>", false};
     }
 
     void insert(int in_slot, const Disk_image* disk, const std::string& name);
@@ -785,6 +794,10 @@ public:
     void reset();
     void tick();
 
+    // a powered off drive is not ticked at all (see 'System::C64::Run_cfg')
+    bool powered() const { return power_on; }
+    void power(bool on);
+
     //bool idle;
     CPU cpu;
     IEC iec;
@@ -903,8 +916,11 @@ private:
     std::vector<Menu::Confirmed_action> menu_confirmed_actions{
         {"Insert blank ?",            [&](){ insert_blank(); }},
         {"Reset drive ?",             [&](){ reset(); }},
+        {"Toggle power ?",            [&](){ power(!power_on); }},
     };
 
+    bool power_on = true;
+
     /*bool& run_cfg_change;
     void install_idle_trap();*/
 };
@@ -12,6 +12,7 @@ void CIA::Core::reset_cold() {
         ones. All other registers are reset to zero.
     */
     s.cnt = true;
+    s.synced_cycle = s.idle_until = 0;
 
     port_a.reset();
     port_b.reset();
@@ -1,8 +1,10 @@
 #ifndef CIA_H_INCLUDED
 #define CIA_H_INCLUDED
 
+#include <algorithm>
 #include "common.h"
 #include "state.h"
+#include "scheduler.h"
 
 
 namespace CIA {
@@ -30,23 +32,25 @@ public:
     Core(
         CS& cs_,
         const PD_out& port_out_a, const PD_out& port_out_b,
-        IO::Int_sig& int_sig_, IO::Int_sig::Src int_src_, const u64& system_cycle)
+        IO::Int_sig& int_sig_, IO::Int_sig::Src int_src_, const u64& system_cycle_,
+        Sched::Event ev_)
       :
         port_a(cs_.port_a, port_out_a), port_b(cs_.port_b, port_out_b),
-        s(cs_),
+        system_cycle(system_cycle_), ev(ev_), s(cs_),
         int_ctrl(cs_.int_ctrl, int_sig_, int_src_),
         timer_b(cs_.timer_b, Int_ctrl::Int_src::tb, tb_pb_bit, cs_.cnt, int_ctrl, sig_null, port_b),
         timer_a(cs_.timer_a, Int_ctrl::Int_src::ta, ta_pb_bit, cs_.cnt, int_ctrl, timer_b.tick_ta, port_b),
-        tod(cs_.tod, timer_a.s.cr, int_ctrl, system_cycle) {}
+        tod(cs_.tod, timer_a.s.cr, int_ctrl, system_cycle_) {}
 
     IO::Port port_a;
     IO::Port port_b;
 
-    void reset_warm() { int_ctrl.reset(); }
+    void reset_warm() { wake(); int_ctrl.reset(); }
 
     void reset_cold();
 
     void r(const u8& ri, u8& data) {
+        wake();
         _tick();
         r_ticked = true;
 
@@ -71,6 +75,8 @@ public:
     }
 
     void w(const u8& ri, const u8& data) {
+        wake();
+
         switch (ri) {
             case pra:      port_a.w_pd(data);      return;
             case prb:      port_b.w_pd(data);      return;
@@ -97,27 +103,45 @@ public:
     }
 
     void peek(const u8& ri, u8& data) const {
+        const u64 idle_n = pending(system_cycle);
+
         switch (ri) {
-            case pra:      data = port_a.r_pd();       return;
-            case prb:      data = r_prb();             return;
-            case ddra:     data = port_a.r_dd();       return;
-            case ddrb:     data = port_b.r_dd();       return;
-            case ta_lo:    data = timer_a.r_lo();      return;
-            case ta_hi:    data = timer_a.r_hi();      return;
-            case tb_lo:    data = timer_b.r_lo();      return;
-            case tb_hi:    data = timer_b.r_hi();      return;
-            case tod_10th: data = tod.peek_10th();     return;
-            case tod_sec:  data = tod.r_sec();         return;
-            case tod_min:  data = tod.r_min();         return;
-            case tod_hr:   data = tod.peek_hr();       return;
-            case sdr:      data = 0x00;                return; // TODO
-            case icr:      data = int_ctrl.peek_icr(); return;
-            case cra:      data = timer_a.s.cr;        return;
-            case crb:      data = timer_b.s.cr;        return;
+            case pra:      data = port_a.r_pd();              return;
+            case prb:      data = r_prb();                    return;
+            case ddra:     data = port_a.r_dd();              return;
+            case ddrb:     data = port_b.r_dd();              return;
+            case ta_lo:    data = timer_a.peek(idle_n);       return;
+            case ta_hi:    data = timer_a.peek(idle_n) >> 8;  return;
+            case tb_lo:    data = timer_b.peek(idle_n);       return;
+            case tb_hi:    data = timer_b.peek(idle_n) >> 8;  return;
+            case tod_10th: data = tod.peek_10th();            return;
+            case tod_sec:  data = tod.r_sec();                return;
+            case tod_min:  data = tod.r_min();                return;
+            case tod_hr:   data = tod.peek_hr();              return;
+            case sdr:      data = 0x00;                       return; // TODO
+            case icr:      data = int_ctrl.peek_icr();        return;
+            case cra:      data = timer_a.s.cr;               return;
+            case crb:      data = timer_b.s.cr;               return;
         }
     }
 
-    void tick() { if (!r_ticked) _tick(); else r_ticked = false; }
+    // to be run (at least) when the event is due
+    void tick() {
+        if (r_ticked) {
+            r_ticked = false;
+            ev.at(system_cycle + 1);
+            return;
+        }
+        if (system_cycle < s.idle_until) { // (synced lazily)
+            ev.at(s.idle_until);
+            return;
+        }
+
+        sync(system_cycle - 1);
+        _tick();
+        s.synced_cycle = system_cycle;
+        plan_idle();
+    }
 
     void set_cnt(bool high) { // TODO (sdr...)
         if (high && !s.cnt) {
@@ -137,6 +161,49 @@ private:
         tod.tick();
     }
 
+    /*  Idling: as long as the timers are just counting down (or stopped), the TOD
+        is not due and the interrupt output is settled, a tick would only decrement
+        the counting timers. Such cycles are not ticked, instead the timers are
+        'synced' (decremented by the number of idle cycles) on demand, i.e. before
+        any access, and before the next cycle that needs a real tick (= the next
+        event: timer reaching 1, TOD pin pulse). Cycle exact, as the state at any
+        observable point is the same as with ticking every cycle.
+        The next cycle to tick is posted as an event to the system scheduler.
+    */
+    void plan_idle() {
+        s.idle_until = system_cycle + 1;
+        if (int_ctrl.settled()) {
+            const u64 ticks = std::min(timer_a.idle_ticks(), timer_b.idle_ticks());
+            s.idle_until = std::min(s.idle_until + ticks, tod.next_pulse());
+        }
+        ev.at(s.idle_until);
+    }
+
+    u64 pending(u64 cycle) const { // idle ticks not yet synced (up to & including 'cycle')
+        if (s.idle_until <= s.synced_cycle + 1) return 0;
+        const u64 last = std::min(cycle, s.idle_until - 1);
+        return last > s.synced_cycle ? last - s.synced_cycle : 0;
+    }
+
+    void sync(u64 cycle) {
+        if (const u64 n = pending(cycle)) {
+            timer_a.idle(n);
+            timer_b.idle(n);
+            s.synced_cycle += n;
+        }
+    }
+
+    // before an access (within the current cycle, i.e. before it is ticked)
+    void wake() {
+        sync(system_cycle - 1);
+        s.idle_until = 0;
+        ev.at(system_cycle);
+    }
+
+    const u64& system_cycle;
+
+    Sched::Event ev;
+
     // to keep in sync with the cpu (if cpu does a read, we must tick first)
     bool r_ticked = false;
 
@@ -182,6 +249,14 @@ private:
 
         u8 peek_icr() const { return s.icr; }
 
+        // nothing would change on tick
+        bool settled() const {
+            if (s.new_icr) return false;
+            return (s.icr & s.mask)
+                ? ((s.icr & ICR_R::ir) && int_sig.is_set(int_id))
+                : !int_sig.is_set(int_id);
+        }
+
         void tick() {
             if (s.icr & s.mask) {
                 s.icr |= ICR_R::ir;
@@ -250,6 +325,22 @@ private:
         u8 r_lo() const { return s.timer; }
         u8 r_hi() const { return s.timer >> 8; }
 
+        u16 peek(u64 idle_n) const { return s.t_ctrl ? s.timer - idle_n : s.timer; }
+
+        // number of upcoming ticks that would just count down (or do nothing)
+        u64 idle_ticks() const {
+            const u8 t_os_steady = (s.cr & CR::oneshot) ? 0x0f : 0x00;
+            if (s.pb_pulse || s.t_os != t_os_steady) return 0;
+
+            const bool counting = (s.inmode == im_phi2) && (s.cr & CR::run);
+            if (!counting) return (s.t_ctrl == 0x00) ? ~u32(0) : 0;
+            if (s.t_ctrl != 0x15) return 0; // (ticks @t+0, t+1, t+2)
+
+            return (s.timer > 0x0001) ? s.timer - 1 : 0;
+        }
+
+        void idle(u64 n) { if (s.t_ctrl) s.timer -= n; }
+
         void w_lo(const u8& data) {
             s.latch = (s.latch & 0xff00) | data;
         }
@@ -458,6 +549,10 @@ private:
 
         u8 peek_10th() const { return s.time[s.r_src].tnth; }
         u8 peek_hr() const { return s.time[s.r_src].hr; }
+
+        u64 next_pulse() const { // (an upcoming cycle that needs a tick)
+            return running() ? (system_cycle / tod_pin_freq + 1) * tod_pin_freq : ~u64(0);
+        }
     
         void tick() {
             const bool tod_pin_pulse = (system_cycle % tod_pin_freq == 0);
@@ -5,6 +5,7 @@
 #include <string>
 #include <optional>
 #include <cstdio>
+#include <algorithm>
 
 
 using u8  = MOS6502::u8;
@@ -14,6 +15,7 @@ using i16 = int16_t;
 using u32 = uint32_t;
 using i32 = int32_t;
 using u64 = uint64_t;
+using i64 = int64_t;
 
 
 /*
@@ -106,20 +108,29 @@ enum Color : u8 {
 
 
 namespace Log {
+    // The line is formatted first & then printed with a single 'fprintf' (which
+    // locks the stream), i.e. lines logged from multiple threads do not interleave.
+    template<typename... Args>
+    void print(FILE* out, const char* tag, const char* fmt, Args... args) {
+        const int len = snprintf(nullptr, 0, fmt, args...);
+        std::string msg(std::max(len, 0), '\0');
+        snprintf(msg.data(), msg.size() + 1, fmt, args...);
+        fprintf(out, "%s%s\n", tag, msg.c_str());
+        fflush(out);
+    }
+
     template<typename... Args>
     void info(const char* fmt, Args... args) {
-        printf("[i] ");
-        printf(fmt, args...);
-        printf("\n");
-        fflush(stdout);
+#ifdef BENCH
+        print(stderr, "[i] ", fmt, args...); // (stdout is for the results)
+#else
+        print(stdout, "[i] ", fmt, args...);
+#endif
     }
 
     template<typename... Args>
     void error(const char* fmt, Args... args) {
-        fprintf(stderr, "[#] ");
-        fprintf(stderr, fmt, args...);
-        fprintf(stderr, "\n");
-        fflush(stderr);
+        print(stderr, "[#] ", fmt, args...);
     }
 }
 
@@ -167,7 +178,7 @@ namespace Key_code {
 
     enum System : u8 {
         nop = GS,
-        rst_cold, rst_warm, save_state, mode_stepped, mode_unlimited,
+        rst_cold, rst_warm, save_state, rec_input, mode_stepped, mode_unlimited,
         step_cycle, step_instr, step_line, step_frame,
         swap_joy, tgl_fscr,
         exp_btn_1,
@@ -176,6 +187,7 @@ namespace Key_code {
         menu_root, menu_audio, menu_video, menu_vid_col, menu_disk, menu_perf,
         menu_exp, menu_xtra, menu_att_reu, menu_quit,
         rot_dsk, tgl_wp,
+        rewind,
         shutdown
     };
 
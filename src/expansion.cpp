@@ -127,6 +127,19 @@ void Expansion::button_1(State::System& s) {
     }
 }
 
+
+Maybe<std::size_t> Expansion::state_size(u16 type) {
+    switch (type) {
+        #define T(t) case t: return T##t::state_size;
+
+        T(0) T(1) T(2) T(3) T(6) T(12) T(21) T(34)
+
+        #undef T
+
+        default: return {};
+    }
+}
+
 /*
 Result T5_Ocean_type_1(const Files::CRT& crt, Ctx& ctx) {
     u32 exp_mem_addr = 0x0001; // current bank stored at 0x0000
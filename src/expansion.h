@@ -86,6 +86,8 @@ protected:
 
 struct T0 : public Base { // T0 None
     T0(State::System& s) : Base(s) {}
+
+    static constexpr std::size_t state_size = 0; // the in-use part of 's.exp.state' (see 'state_size()')
 };
 
 
@@ -96,6 +98,7 @@ struct T1 : public Base { // T1: REU (512 kb)
     T1(::State::System& s) : Base(s) {}
 
     ES::REU& r{s.exp.state.reu};
+    static constexpr std::size_t state_size = sizeof(ES::REU);
 
     enum R : u8 {
         status = 0, cmd, saddr_l, saddr_h, raddr_l, raddr_h, raddr_b, tlen_l,
@@ -333,6 +336,7 @@ struct T2 : public Base { // T2 Generic
     T2(State::System& s) : Base(s) {}
 
     ES::Generic& g{s.exp.state.generic};
+    static constexpr std::size_t state_size = sizeof(ES::Generic);
 
     void roml_r(const u16& a, u8& d) { d = g.mem[a]; }
     void romh_r(const u16& a, u8& d) { d = g.mem[a]; }
@@ -363,6 +367,7 @@ struct T3 : public Base { // T3 Action_Replay
     T3(State::System& s) : Base(s) {}
 
     ES::Action_Replay& ar{s.exp.state.action_replay};
+    static constexpr std::size_t state_size = sizeof(ES::Action_Replay);
 
     void roml_r(const u16& a, u8& d) {
         d = ram_active() ? ar.ram[a & 0x1fff] : ar.rom[ar.bank][a & 0x1fff];
@@ -460,6 +465,7 @@ struct T12 : public Base { // T12 Epyx Fastload
     T12(State::System& s) : Base(s) {}
 
     ES::Epyx_Fastload& efl{s.exp.state.epyx_fl};
+    static constexpr std::size_t state_size = sizeof(ES::Epyx_Fastload);
 
     void roml_r(const u16& a, u8& d) { act(); d = efl.mem[a]; }
     void io1_r(const u16& a, u8& d)  { UNUSED2(a, d); act(); }
@@ -500,6 +506,7 @@ struct T21 : public Base { // T21 Magic Desk
     T21(State::System& s) : Base(s) {}
 
     ES::Magic_Desk& md{s.exp.state.magic_desk};
+    static constexpr std::size_t state_size = sizeof(ES::Magic_Desk);
 
     void roml_r(const u16& a, u8& d) { d = md.mem[md.bank][a & 0x1fff]; }
 
@@ -544,6 +551,7 @@ struct T34 : public Base { // T34 EasyFlash
     T34(State::System& s) : Base(s) {}
 
     ES::EasyFlash& ef{s.exp.state.easyflash};
+    static constexpr std::size_t state_size = sizeof(ES::EasyFlash);
 
     void roml_r(const u16& a, u8& d) { d = ef.roml[ef.bank][a & 0x1fff]; }
     void romh_r(const u16& a, u8& d) { d = ef.romh[ef.bank][a & 0x1fff]; }
@@ -611,6 +619,9 @@ void reset(State::System& s);
 
 void button_1(State::System& s);
 
+// size of the in-use part of 's.exp.state' (for the state files), {} for an unknown type
+Maybe<std::size_t> state_size(u16 type);
+
 template<typename Bus>
 void tick(State::System& s, Bus& bus) {
     //#define T(t) case t: T##t##_kludge<Bus>{s, bus}.tick(); break;
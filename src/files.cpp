@@ -2,7 +2,14 @@
 #include "files.h"
 #include <regex>
 #include <filesystem>
+#include <map>
+#include <cstring>
+#include <cstddef>
+#include <type_traits>
+#include <fstream>
 #include "utils.h"
+#include "lz4.h"
+#include "expansion.h"
 
 
 
@@ -16,7 +23,7 @@ static const char* win_drive_list_filename = "?:/";
 static const char* unmount_filename = ":";
 
 static const int SYS_SNAP_SIZE = sizeof(System_snapshot);
-static const int HD_FILE_SIZE_MAX = SYS_SNAP_SIZE;
+static const int HD_FILE_SIZE_MAX = SYS_SNAP_SIZE + SYS_SNAP_SIZE / 64; // (some slack for the chunked ones)
 static const int C64_BIN_SIZE_MIN = 0x0003; // TODO: check
 static const int C64_BIN_SIZE_MAX = 0xffff; // TODO: check
 static const int T64_SIZE_MIN = 0x60;
@@ -51,7 +58,7 @@ static constexpr u8 crt_signature[] = {
 
 
 
-File::Type file_type(const Bytes& file) {
+File::Type file_type(Byte_view file) {
     auto is_crt = [&]() {
         return std::size(file) >= CRT_SIZE_MIN
                     && std::equal(std::begin(crt_signature), std::end(crt_signature),
@@ -83,11 +90,9 @@ File::Type file_type(const Bytes& file) {
         return (std::size(file) >= C64_BIN_SIZE_MIN) && std::size(file) <= C64_BIN_SIZE_MAX;
     };
 
-    auto is_sys_snap = [&]() {
-        const auto& sign = System_snapshot::signature;
-        return std::size(file) == SYS_SNAP_SIZE
-            && std::equal(std::begin(sign), std::end(sign), std::begin(file));
-    };
+    auto is_sys_snap = [&]() { return System_snapshot::is_snapshot(file); };
+
+    auto is_input_log = [&]() { return Input_log::is_input_log(file); };
 
     using Type = File::Type;
 
@@ -95,8 +100,9 @@ File::Type file_type(const Bytes& file) {
     if (is_t64()) return Type::t64;
     if (is_g64()) return Type::g64;
     if (is_d64()) return Type::d64;
+    if (is_sys_snap()) return Type::sys_snap; // (a compressed one may look like a c64 bin)
+    if (is_input_log()) return Type::input_log;
     if (is_c64_bin()) return Type::c64_bin;
-    if (is_sys_snap()) return Type::sys_snap;
 
     return Type::unknown;
 }
@@ -108,8 +114,8 @@ File read(const std::string& path) {
 
     try {
         if (fs::file_size(fs_path) <= HD_FILE_SIZE_MAX) {
-            if (auto data = read_file(path); data) {
-                return File{file_type(*data), name, *data};
+            if (auto data = Blob::map_file(path); data) {
+                return identify(name, std::move(*data));
             }
         } else {
             Log::error("File oversized");
@@ -122,6 +128,12 @@ File read(const std::string& path) {
 }
 
 
+File identify(const std::string& name, Blob data) {
+    const auto type = file_type(data);
+    return File{type, name, std::move(data)};
+}
+
+
 File generate_basic_info_list(const File& file) {
     using Type = File::Type;
 
@@ -439,7 +451,7 @@ Bytes d64_read_file(const D64& d64, const D64::BL& start) {
 File load_from_t64(const T64& t64, const std::string& what) { UNUSED(what);
     auto file = t64.first_file();
     if (std::size(file) > 2 && std::size(file) <= C64_BIN_SIZE_MAX)
-        return File{File::Type::c64_bin, "", file};
+        return File{File::Type::c64_bin, "", std::move(file)};
     else
         return NO_FILE;
 }
@@ -509,7 +521,7 @@ File load_from_d64(const D64& d64, const std::string& what) {
         const auto filename = extract_string(entry->filename);
         if (match(filename)) {
             auto file = d64_read_file(d64, entry->file_start);
-            if (file.size() > 0) return File{File::Type::c64_bin, filename, file};
+            if (file.size() > 0) return File{File::Type::c64_bin, filename, std::move(file)};
             break;
         }
     }
@@ -533,4 +545,426 @@ Loader init_loader(const std::string& init_dir) {
 }
 
 
+/* ------------------------------ state files ------------------------------ */
+
+struct Snapshot_header {
+    enum Flags : u8 { compressed = 0x01 };
+
+    char sign[16];
+    U16l version;
+    u8 little_endian;
+    u8 flags;
+    U32l data_size; // (uncompressed) total size of the chunks
+};
+
+
+struct Chunk_header {
+    char id[4];
+    U32l size;
+};
+
+
+struct Chunk {
+    const char* id;
+    u8* data;
+    std::size_t size;
+};
+
+
+static U16l u16l(u16 v) { return {u8(v), u8(v >> 8)}; }
+static U32l u32l(u32 v) { return {u8(v), u8(v >> 8), u8(v >> 16), u8(v >> 24)}; }
+
+
+static bool host_little_endian() {
+    const u16 v = 1;
+    return *((const u8*)&v) == 1;
+}
+
+
+template<typename T>
+static Chunk chunk(const char* id, T& t) { return {id, (u8*)&t, sizeof(t)}; }
+
+static Chunk chunk(const char* id, void* from, void* to) { // [from, to)
+    return {id, (u8*)from, std::size_t((u8*)to - (u8*)from)};
+}
+
+
+// the fixed size chunks (the rest: 'EXPS' (expansion state), 'DTRK' (1541 disk tracks))
+static std::vector<Chunk> fixed_chunks(System_snapshot& ss) {
+    auto& s = ss.sys_state;
+    auto& dc = s.c1541.disk_ctrl;
+
+    return {
+        chunk("RAM ", s.ram),
+        chunk("CRAM", s.color_ram),
+        chunk("BUS ", &s.ba, &s.pla), // ba, dma, bus
+        chunk("PLA ", s.pla),
+        chunk("EXP ", &s.exp, &s.exp.state), // type, ticker, name
+        chunk("IHUB", s.int_hub),
+        chunk("INPT", s.input_matrix),
+        chunk("VIC ", s.vic),
+        chunk("CPU ", s.cpu),
+        chunk("CIA1", s.cia1),
+        chunk("CIA2", s.cia2),
+        chunk("DIEC", s.c1541.iec),
+        chunk("DCTL", &dc, &dc.track_len),
+        chunk("DSYS", s.c1541.system),
+        chunk("SID ", ss.sid),
+    };
+}
+
+
+static bool signed_with(Byte_view file, const char (&sign)[System_snapshot::sign_len]) {
+    return std::size(file) >= std::size(sign) && std::equal(std::begin(sign), std::end(sign), std::begin(file));
+}
+
+
+static bool is_raw_snapshot(Byte_view file) {
+    return std::size(file) == SYS_SNAP_SIZE && signed_with(file, System_snapshot::signature);
+}
+
+
+bool System_snapshot::is_snapshot(Byte_view file) {
+    return is_raw_snapshot(file)
+        || (std::size(file) >= sizeof(Snapshot_header) && signed_with(file, file_signature));
+}
+
+
+Bytes System_snapshot::pack(bool compress) const {
+    // (the chunk table is shared with 'unpack()', nothing gets written here though)
+    auto& ss = const_cast<System_snapshot&>(*this);
+    const auto& s = sys_state;
+    const auto& dc = s.c1541.disk_ctrl;
+
+    Bytes chunks;
+    chunks.reserve(SYS_SNAP_SIZE / 4);
+
+    auto put_header = [&](const char* id, std::size_t size) {
+        Chunk_header ch{{id[0], id[1], id[2], id[3]}, u32l(size)};
+        chunks.insert(chunks.end(), (const u8*)&ch, (const u8*)&ch + sizeof(ch));
+    };
+    auto put_data = [&](const void* data, std::size_t size) {
+        chunks.insert(chunks.end(), (const u8*)data, (const u8*)data + size);
+    };
+
+    for (const auto& c : fixed_chunks(ss)) {
+        put_header(c.id, c.size);
+        put_data(c.data, c.size);
+    }
+
+    const auto exp_size = Expansion::state_size(s.exp.type).value(); // (a type in use is a known one)
+    put_header("EXPS", exp_size);
+    put_data(&s.exp.state, exp_size);
+
+    std::size_t tracks_size = sizeof(dc.track_len);
+    for (auto len : dc.track_len) tracks_size += len;
+    put_header("DTRK", tracks_size);
+    put_data(dc.track_len, sizeof(dc.track_len));
+    for (int t = 0; t < dc.track_count; ++t) put_data(dc.track_data[t], dc.track_len[t]);
+
+    Snapshot_header h{
+        {}, u16l(file_version), host_little_endian(),
+        u8(compress ? Snapshot_header::compressed : 0), u32l(chunks.size())
+    };
+    std::copy(std::begin(file_signature), std::end(file_signature), h.sign);
+
+    Bytes file;
+    file.reserve(sizeof(h) + chunks.size());
+    file.insert(file.end(), (const u8*)&h, (const u8*)&h + sizeof(h));
+
+    if (compress) LZ4::compress(chunks.data(), chunks.size(), file);
+    else file.insert(file.end(), chunks.begin(), chunks.end());
+
+    return file;
+}
+
+
+bool System_snapshot::unpack(Byte_view file) {
+    if (!is_snapshot(file)) {
+        Log::error("State file: invalid");
+        return false;
+    }
+
+    if (is_raw_snapshot(file)) {
+        const auto& raw = *((const System_snapshot*)file.data()); // brutal...
+        sys_state = raw.sys_state;
+        sid = raw.sid;
+        return true;
+    }
+
+    const auto& h = *((const Snapshot_header*)file.data());
+    if (h.version != file_version) {
+        Log::error("State file: unsupported version %d", (int)h.version);
+        return false;
+    }
+    if (bool(h.little_endian) != host_little_endian()) {
+        Log::error("State file: incompatible endianness");
+        return false;
+    }
+
+    const u8* payload = file.data() + sizeof(h);
+    const std::size_t payload_size = file.size() - sizeof(h);
+    const std::size_t size = h.data_size;
+
+    // (if not compressed, used in place)
+    Bytes decompressed;
+    const u8* chunks = payload;
+    if (h.flags & Snapshot_header::compressed) {
+        if (size > 2 * SYS_SNAP_SIZE) {
+            Log::error("State file: corrupted");
+            return false;
+        }
+        decompressed.resize(size);
+        if (!LZ4::decompress(payload, payload_size, decompressed.data(), size)) {
+            Log::error("State file: corrupted");
+            return false;
+        }
+        chunks = decompressed.data();
+    } else if (payload_size != size) {
+        Log::error("State file: corrupted");
+        return false;
+    }
+
+    // index & verify everything before touching the state
+    std::map<std::string, Chunk> found;
+    for (std::size_t pos = 0; pos < size;) {
+        if (size - pos < sizeof(Chunk_header)) {
+            Log::error("State file: corrupted");
+            return false;
+        }
+        const auto& ch = *((const Chunk_header*)&chunks[pos]);
+        pos += sizeof(ch);
+        if (ch.size > size - pos) {
+            Log::error("State file: corrupted");
+            return false;
+        }
+        found[std::string(ch.id, 4)] = Chunk{nullptr, (u8*)&chunks[pos], ch.size}; // (read only)
+        pos += ch.size;
+    }
+
+    auto get = [&](const char* id, Maybe<std::size_t> expected_size = {}) -> Maybe<Chunk> {
+        const auto c = found.find(id);
+        if (c == found.end() || (expected_size && c->second.size != *expected_size)) {
+            Log::error("State file: chunk '%s' missing or incompatible", id);
+            return {};
+        }
+        return c->second;
+    };
+
+    const auto fixed = fixed_chunks(*this);
+    for (const auto& c : fixed) {
+        if (!get(c.id, c.size)) return false;
+    }
+
+    // the 'EXP ' chunk is 's.exp' up to 'state', starting with the type
+    using Exp = State::System::Expansion;
+    static_assert(std::is_standard_layout_v<Exp> && offsetof(Exp, type) == 0);
+    static_assert(offsetof(Exp, type) + sizeof(Exp::type) <= offsetof(Exp, state));
+
+    decltype(Exp::type) exp_type;
+    std::memcpy(&exp_type, found["EXP "].data, sizeof(exp_type));
+    const auto exp_size = Expansion::state_size(exp_type);
+    if (!exp_size) {
+        Log::error("State file: unsupported expansion type %d", (int)exp_type);
+        return false;
+    }
+    const auto exps = get("EXPS", *exp_size);
+    if (!exps) return false;
+
+    using Disk_ctrl = State::C1541::Disk_ctrl;
+    u16 track_len[Disk_ctrl::track_count];
+    const auto trks = get("DTRK");
+    if (!trks || trks->size < sizeof(track_len)) return false;
+    std::memcpy(track_len, trks->data, sizeof(track_len));
+    std::size_t tracks_size = sizeof(track_len);
+    for (auto len : track_len) {
+        if (len > Disk_ctrl::max_track_len) tracks_size = 0; // (flags it)
+        else tracks_size += len;
+    }
+    if (tracks_size != trks->size) {
+        Log::error("State file: chunk 'DTRK' incompatible");
+        return false;
+    }
+
+    // apply
+    for (const auto& c : fixed) std::memcpy(c.data, found[c.id].data, c.size);
+
+    auto& s = sys_state;
+    std::memset(&s.exp.state, 0, sizeof(s.exp.state));
+    std::memcpy(&s.exp.state, exps->data, exps->size);
+
+    auto& dc = s.c1541.disk_ctrl;
+    std::memcpy(dc.track_len, track_len, sizeof(track_len));
+    const u8* td = trks->data + sizeof(track_len);
+    for (int t = 0; t < dc.track_count; ++t) {
+        std::memcpy(dc.track_data[t], td, track_len[t]);
+        td += track_len[t];
+    }
+
+    return true;
+}
+
+
+Snapshot_saver::~Snapshot_saver() {
+    if (!worker.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        quit = true;
+    }
+    wake.notify_one();
+    worker.join(); // (a pending save gets finished first)
+}
+
+
+bool Snapshot_saver::save(const System_snapshot& snap, const std::string& path) {
+    if (stat == Status::saving) return false;
+
+    if (!snap_copy) snap_copy = std::make_unique<System_snapshot>();
+    snap_copy->sys_state = snap.sys_state;
+    snap_copy->sid = snap.sid;
+
+    filepath = path;
+    stat = Status::saving;
+
+    if (!worker.joinable()) worker = std::thread(&Snapshot_saver::work, this);
+
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        pending = true;
+    }
+    wake.notify_one();
+
+    return true;
+}
+
+
+void Snapshot_saver::work() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mut);
+            wake.wait(lock, [this]{ return pending || quit; });
+            if (!pending) return;
+            pending = false;
+        }
+
+        const Bytes data = snap_copy->pack();
+
+        // written aside & then renamed over, i.e. a file being read (mapped) is never
+        // truncated under the reader
+        const std::string tmp_path = filepath + ".tmp";
+        bool ok = false;
+        if (auto f = std::ofstream(tmp_path, std::ios::binary)) {
+            f.write((const char*)data.data(), data.size());
+            f.close();
+            ok = bool(f);
+        }
+        if (ok) {
+            std::error_code ec;
+            std::filesystem::rename(tmp_path, filepath, ec);
+            ok = !ec;
+        }
+
+        if (ok) Log::info("State saved: %s (%d bytes)", filepath.c_str(), (int)data.size());
+        else Log::error("save state failed: %s", filepath.c_str());
+
+        stat = ok ? Status::saved : Status::failed;
+    }
+}
+
+/* ------------------------------ input logs ------------------------------- */
+
+struct Input_log_header {
+    char sign[16];
+    U16l version;
+    U32l state_size;
+    U32l event_count;
+};
+
+
+struct Input_log_event {
+    U32l cycle_lo;
+    U32l cycle_hi;
+    u8 target;
+    u8 code;
+    u8 down;
+    U16l path_len; // followed by the path (for 'drop')
+    U32l data_len; // followed by the file contents (for 'drop')
+};
+
+
+bool Input_log::is_input_log(Byte_view file) {
+    return std::size(file) >= sizeof(Input_log_header) && signed_with(file, file_signature);
+}
+
+
+Bytes Input_log::pack() const {
+    Input_log_header h{{}, u16l(file_version), u32l(start_state.size()), u32l(events.size())};
+    std::copy(std::begin(file_signature), std::end(file_signature), h.sign);
+
+    Bytes file;
+    file.insert(file.end(), (const u8*)&h, (const u8*)&h + sizeof(h));
+    file.insert(file.end(), start_state.begin(), start_state.end());
+
+    for (const auto& ev : events) {
+        const Input_log_event e{
+            u32l(ev.cycle), u32l(ev.cycle >> 32), ev.target, ev.code, ev.down,
+            u16l(ev.path.size()), u32l(ev.data.size())
+        };
+        file.insert(file.end(), (const u8*)&e, (const u8*)&e + sizeof(e));
+        file.insert(file.end(), ev.path.begin(), ev.path.end());
+        file.insert(file.end(), ev.data.begin(), ev.data.end());
+    }
+
+    return file;
+}
+
+
+bool Input_log::unpack(Byte_view file) {
+    auto corrupted = [](){ Log::error("Input log: corrupted"); return false; };
+
+    if (!is_input_log(file)) {
+        Log::error("Input log: invalid");
+        return false;
+    }
+
+    const auto& h = *((const Input_log_header*)file.data());
+    if (h.version != file_version) {
+        Log::error("Input log: unsupported version %d", (int)h.version);
+        return false;
+    }
+
+    std::size_t pos = sizeof(h);
+    if (h.state_size > file.size() - pos) return corrupted();
+    Bytes state(file.begin() + pos, file.begin() + pos + h.state_size);
+    pos += h.state_size;
+
+    std::vector<Event> evs;
+    for (u32 n = 0; n < h.event_count; ++n) {
+        if (file.size() - pos < sizeof(Input_log_event)) return corrupted();
+        const auto& e = *((const Input_log_event*)&file[pos]);
+        pos += sizeof(e);
+        if (u64(e.path_len) + e.data_len > file.size() - pos) return corrupted();
+        if (e.target > Event::Target::drop) return corrupted();
+        if (e.target == Event::Target::keyboard && e.code >= 64) return corrupted(); // (matrix bit)
+        if ((e.target == Event::Target::ctrl_port_1 || e.target == Event::Target::ctrl_port_2)
+                && e.code >= 8) return corrupted(); // (port bit)
+
+        const u64 cycle = (u64(e.cycle_hi) << 32) | e.cycle_lo;
+        if (!evs.empty() && cycle < evs.back().cycle) return corrupted();
+
+        const auto path = file.begin() + pos;
+        const auto data = path + e.path_len;
+        evs.push_back({cycle, Event::Target(e.target), e.code, e.down,
+                            std::string(path, data), Bytes(data, data + e.data_len)});
+        pos += e.path_len + e.data_len;
+    }
+    if (pos != file.size()) return corrupted();
+
+    start_state = std::move(state);
+    events = std::move(evs);
+
+    return true;
+}
+
 } // namespace Files
\ No newline at end of file
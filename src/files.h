@@ -4,7 +4,13 @@
 #include <string>
 #include <vector>
 #include <numeric>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "common.h"
+#include "utils.h"
 #include "state.h"
 #include "sid.h"
 
@@ -13,11 +19,11 @@ namespace Files {
 
 
 struct File {
-    enum class Type { none = 0, crt, t64, d64, g64, c64_bin, sys_snap, unknown };
+    enum class Type { none = 0, crt, t64, d64, g64, c64_bin, sys_snap, input_log, unknown };
 
     const Type type;
     const std::string name;
-    Bytes data;
+    Blob data; // mapped, if read from a file
 
     operator bool() const { return type != Type::none; }
     bool identified() const { return (type != Type::none) && (type != Type::unknown); }
@@ -25,6 +31,8 @@ struct File {
 
 File read(const std::string& path);
 
+File identify(const std::string& name, Blob data);
+
 File generate_basic_info_list(const File& file);
 
 using Loader = std::function<File (const std::string&)>;
@@ -49,11 +57,96 @@ public:
     State::System sys_state;
 
     reSID_Wrapper::Core::State sid;
+
+    /*  The state file: a header (signature, version, endianness, flags) followed by
+        chunks ('id', size, data), one for each chip. Only the state in use is stored
+        (i.e. the attached expansion only, the used part of the disk tracks only).
+        Chunk data is as laid out in memory (hence the endianness & version tags, and
+        the chunk sizes are verified on load). Optionally LZ4 compressed.
+        (The raw snapshots (above signature) can still be loaded.)
+    */
+    static constexpr char file_signature[16] = {
+        'c', '6', '4', '_', 'e', 'm', 'u', '_', 's', 'n', 'a', 'p', 's', 'h', 'o', 't'
+    };
+    static constexpr u16 file_version = 2;
+
+    Bytes pack(bool compress = true) const;
+    bool unpack(Byte_view file); // on failure the state is left as it was
+
+    static bool is_snapshot(Byte_view file);
+};
+
+
+/*  Saves snapshots in the background: 'save()' just copies the state (into a buffer
+    allocated once), the packing & writing is done by a worker thread. Only one save
+    can be in progress at a time.
+*/
+class Snapshot_saver {
+public:
+    enum class Status : u8 { idle, saving, saved, failed };
+
+    Snapshot_saver() = default;
+    ~Snapshot_saver();
+
+    Snapshot_saver(const Snapshot_saver&) = delete;
+    Snapshot_saver& operator=(const Snapshot_saver&) = delete;
+
+    bool save(const System_snapshot& snap, const std::string& path); // false if busy
+
+    Status status() const { return stat; } // the result stays until the next save
+
+private:
+    std::unique_ptr<System_snapshot> snap_copy;
+    std::string filepath;
+
+    std::atomic<Status> stat{Status::idle};
+
+    std::thread worker;
+    std::mutex mut;
+    std::condition_variable wake;
+    bool pending = false;
+    bool quit = false;
+
+    void work();
+};
+
+
+/*  Input stamped with the system cycle it was fed to the C64 at (keyboard, controllers,
+    restore key, file drops), replayed at exactly the same cycles (i.e. regardless of
+    the host, or the latency settings). Starts from the state the recording started at.
+    (Not included: the system keys, e.g. a reset.)
+    The file: a header (signature, version, sizes), the start state (as a packed
+    snapshot), and the events (a drop with the dropped file included).
+*/
+struct Input_log {
+    struct Event {
+        enum Target : u8 { keyboard, ctrl_port_1, ctrl_port_2, restore, drop };
+
+        u64 cycle;
+        Target target;
+        u8 code; // Key_code (keyboard, controllers)
+        u8 down;
+        std::string path; // for 'drop'
+        Blob data{}; // for 'drop': the file contents at the drop (the replay does not re-read it)
+    };
+
+    static constexpr char file_signature[16] = {
+        'c', '6', '4', '_', 'e', 'm', 'u', '_', 'i', 'n', 'p', 'u', 't', 'l', 'o', 'g'
+    };
+    static constexpr u16 file_version = 2;
+
+    Bytes start_state; // see 'System_snapshot::pack()'
+    std::vector<Event> events; // ordered by cycle
+
+    Bytes pack() const;
+    bool unpack(Byte_view file); // on failure the log is left as it was
+
+    static bool is_input_log(Byte_view file);
 };
 
 
 struct T64 {
-    const Bytes& data;
+    const Byte_view data;
 
     struct Dir_entry {
         u8 _todo[2]; // types
@@ -86,7 +179,7 @@ struct T64 {
 
 // TODO: handle tracks beyond 35 (upto and including 42)
 struct D64 {
-    const Bytes& data;
+    const Byte_view data;
 
     // standard 35-track disk
     static constexpr int track_count = 35;
@@ -185,7 +278,7 @@ struct D64 {
 
 
 struct G64 {
-    const Bytes data;
+    const Blob data;
 
     struct Header {
         const u8 signature[8];
@@ -214,7 +307,7 @@ struct G64 {
 
 
 struct CRT {
-    const Bytes& data;
+    const Byte_view data;
 
     struct Header {
         struct Version { const u8 major; const u8 minor; };
@@ -1,6 +1,10 @@
+#ifndef HEADLESS
+
 
 #include <array>
+#include <cstring>
 #include "host.h"
+#include "vic_ii_simd.h"
 
 
 
@@ -17,7 +21,7 @@ static const u8 J2 = Input::JOY_ID_BIT;
 
 
 // TODO: analyze... use more scancodes?
-u8 Input::KC_LU_TBL[] = {
+const u8 Input::KC_LU_TBL[] = {
     /* 00..7f : SDL_Keycode 00..7f  --> Key_code */
     // 00..0f
     sy::nop,   sy::nop,   sy::nop,   sy::nop,   sy::nop,   sy::nop,   sy::nop,   sy::nop,
@@ -93,13 +97,13 @@ const u8 Input::SC_LU_TBL[] = {
 const u8 Input::SC_RALT_LU_TBL[] = { // SDL_Scancode with RALT modifier */
     // 00..0f
     sy::nop, sy::nop, sy::nop, sy::nop, sy::menu_audio,sy::nop, sy::menu_vid_col, sy::menu_disk,
-    sy::menu_exp ,sy::exp_btn_1,sy::nop,   sy::nop,   sy::nop, sy::swap_joy, sy::nop,   sy::nop,
+    sy::menu_exp ,sy::exp_btn_1,sy::nop,   sy::nop,   sy::rec_input, sy::swap_joy, sy::nop, sy::nop,
     // 10..1f
     sy::menu_root, sy::nop, sy::nop, sy::menu_perf, sy::menu_quit, sy::menu_att_reu, sy::save_state, sy::nop,
     sy::nop, sy::menu_video,sy::tgl_wp, sy::menu_xtra, sy::nop, sy::nop, sy::step_cycle, sy::step_instr,
     // 20..2f
     sy::step_line, sy::step_frame,   sy::nop,   sy::nop,   sy::nop,   sy::nop,   sy::nop,   kb::eq,
-    sy::nop,   sy::nop,   sy::nop,   sy::nop,   sy::nop,   sy::nop,   sy::nop,   sy::nop,
+    sy::nop,   sy::nop,   sy::rewind,sy::nop,   sy::nop,   sy::nop,   sy::nop,   sy::nop,
     // 30..3f
     sy::nop,   kb::mul,   sy::nop,   sy::nop,   sy::nop,   sy::nop,   sy::nop,   sy::nop,
     sy::nop,   sy::nop,   sy::nop,   sy::nop,   sy::nop,   sy::nop,   sy::nop,   sy::nop,
@@ -114,11 +118,16 @@ const u8 Input::SC_RALT_LU_TBL[] = { // SDL_Scancode with RALT modifier */
 
 
 Input::Input(Handlers& handlers_)
-    : handlers(handlers_), joy_handler{ &handlers_.controller_1, &handlers_.controller_2 }
+    : kc_lu_tbl(std::begin(KC_LU_TBL), std::end(KC_LU_TBL)),
+      handlers(handlers_), keys(handlers_)
 {
+    // while auto shifted: the 'real' right shift disabled
+    keys.auto_shift = [this](bool down) { if (down) disable_sh_r(); else enable_sh_r(); };
+    keys.shift_lock = [this](u8) { set_shift_lock(); };
+
     // find index of left/right shift
-    while (KC_LU_TBL[sh_l_idx] != Key_code::Keyboard::sh_l) ++sh_l_idx;
-    while (KC_LU_TBL[sh_r_idx] != Key_code::Keyboard::sh_r) ++sh_r_idx;
+    while (kc_lu_tbl[sh_l_idx] != Key_code::Keyboard::sh_l) ++sh_l_idx;
+    while (kc_lu_tbl[sh_r_idx] != Key_code::Keyboard::sh_r) ++sh_r_idx;
 
     // TODO: allow selection (for now just the first two found are attached)
     // TODO: joystick calibration/configuration...
@@ -150,14 +159,6 @@ void Input::poll() { // TODO: filtering?
 }
 
 
-void Input::swap_joysticks() {
-    Sig_key* t = joy_handler[0];
-    joy_handler[0] = joy_handler[1];
-    joy_handler[1] = t;
-    Log::info("Joysticks swapped");
-}
-
-
 u8 Input::translate_sdl_key() {
     static const i32 MAX_KC             = SDLK_SLEEP;
     static const i32 LAST_CHAR_KC       = SDLK_DELETE;
@@ -176,9 +177,9 @@ u8 Input::translate_sdl_key() {
     if (key_sym.sym <= MAX_KC) {
         // most mapped on keycode, some on scancode
         if (key_sym.sym <= LAST_CHAR_KC)
-            return KC_LU_TBL[key_sym.sym];
+            return kc_lu_tbl[key_sym.sym];
         else if (key_sym.sym >= FIRST_NON_CHAR_KC)
-            return KC_LU_TBL[key_sym.sym - OFFSET_NON_CHAR_KC];
+            return kc_lu_tbl[key_sym.sym - OFFSET_NON_CHAR_KC];
         else if (key_sym.scancode >= 0x2e && key_sym.scancode <= 0x35)
             return SC_LU_TBL[key_sym.scancode - 0x2e];
     }
@@ -187,64 +188,6 @@ u8 Input::translate_sdl_key() {
 }
 
 
-void Input::output_key(u8 code, u8 down) {
-    auto group = code >> 6;
-    switch (group) {
-        case Key_code::Group::keyboard:
-            handlers.keyboard(code, down);
-            break;
-
-        case Key_code::Group::keyboard_ext: {
-            using ke = Key_code::Keyboard_ext;
-            switch (code) {
-                case ke::crs_u: case ke::f6: case ke::f4:
-                case ke::f2:    case ke::f8: case ke::crs_l: {
-                    // 6 of these are actually used (for crs_u, f6, f4, f2, f8, crs_l)
-                    static const u8 BIT[] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
-
-                    if (down) {
-                        if (sh_r_down == 0x00) {
-                            // first 'auto shifted' key held down
-                            //   --> set 'right shift' key down & disable the 'real' one
-                            handlers.keyboard(Key_code::Keyboard::sh_r, true);
-                            disable_sh_r();
-                        }
-                        sh_r_down |= BIT[code & 0x7]; // keep track of key presses
-                    } else {
-                        sh_r_down &= (~BIT[code & 0x7]);
-                        if (sh_r_down == 0x00) {
-                            // last 'auto shifted' key released
-                            //   --> set 'right shift' key up & enable the 'real' one
-                            handlers.keyboard(Key_code::Keyboard::sh_r, false);
-                            enable_sh_r();
-                        }
-                    }
-
-                    const u8 kc_offset = Key_code::Keyboard_ext::crs_l - Key_code::Keyboard::crs_r;
-                    handlers.keyboard(code - kc_offset, down); // send the corresponding 'real' code
-
-                    break;
-                }
-                case ke::s_lck: set_shift_lock();       break;
-                case ke::rstre: handlers.restore(down); break;
-            }
-
-            break;
-        }
-
-        case Key_code::Group::joystick: {
-            auto id = code & JOY_ID_BIT ? 1 : 0;
-            (*joy_handler[id])(code & 0x7, down);
-            break;
-        }
-
-        case Key_code::Group::system:
-            handlers.sys(code, down);
-            break;
-    }
-}
-
-
 void Input::handle_joy_axis() {
     /*  SDL Wiki: "On most modern joysticks the X axis is usually represented by axis 0
     and the Y axis by axis 1. The value returned by SDL_JoystickGetAxis()
@@ -255,7 +198,7 @@ void Input::handle_joy_axis() {
     static const int X_AXIS = 0;
 
     SDL_JoyAxisEvent& joy_ev = sdl_ev.jaxis;
-    Sig_key& output = get_joy_output(joy_ev.which);
+    auto output = [&](u8 code, u8 down) { output_joy(joy_ev.which, code, down); };
 
     using Key_code::Joystick;
 
@@ -278,16 +221,23 @@ void Input::handle_joy_axis() {
 
 
 
-void Video_out::put(const u8* vic_frame) {
+void Video_out::put(const u8* vic_frame, const bool* changed_lines) {
+    frame.upload(vic_frame, changed_lines);
+    present();
+}
+
+
+void Video_out::present() {
     //SDL_RenderClear(renderer);
-    frame.put(vic_frame, renderer);
+    frame.frame.copy(renderer);
     mask.put(renderer);
-    flip();
+    SDL_RenderPresent(renderer);
 }
 
 
 Video_out::SDL_frame::SDL_frame(int max_w_, int max_h_, SDL_TextureAccess ta_, SDL_BlendMode bm_)
-    : max_w(max_w_), max_h(max_h_), ta(ta_), bm(bm_), pixels(new u32[max_w * max_h])
+    : max_w(max_w_), max_h(max_h_), ta(ta_), bm(bm_),
+      pixels(ta == SDL_TEXTUREACCESS_STATIC ? new u32[max_w * max_h] : nullptr)
 {
 }
 
@@ -305,6 +255,8 @@ void Video_out::SDL_frame::connect(SDL_Renderer* renderer) {
 void Video_out::Frame::upd_palette(const Settings& set) {
     get_Colodore(palette, set.brightness, set.contrast, set.saturation);
     palette[0] = 0x020202; // keep it blackish...
+
+    redraw = true;
 }
 
 
@@ -313,83 +265,48 @@ void Video_out::Frame::upd_sharpness(const Settings& set) {
 
     static constexpr std::array<Sz, 5> px_sz{{ {1, 1}, {1, 2}, {2, 2}, {3, 3} }};
 
-    frame.srcrect.w = VIC_II::FRAME_WIDTH * px_sz[set.sharpness].w;
-    frame.srcrect.h = VIC_II::FRAME_HEIGHT * px_sz[set.sharpness].h;
-
-    switch (set.sharpness) {
-        case 0: // {1, 1}
-            draw = [&](const u8* vic_frame) {
-                for (int pos = 0; pos < VIC_II::FRAME_SIZE; ++pos) {
-                    frame.pixels[pos] = col(vic_frame[pos]);
-                }
-                const auto bytes_per_row = 1 * (bytes_per_pixel * VIC_II::FRAME_WIDTH);
-                SDL_UpdateTexture(frame.texture, 0, (void*)frame.pixels, bytes_per_row);
-            };
-            break;
-        case 1: // {1, 2}
-            draw = [&](const u8* vic_frame) {
-                u32* scan = frame.pixels;
-
-                for (int y = 0; y < VIC_II::FRAME_HEIGHT; ++y) {
-                    for (int x = 0; x < VIC_II::FRAME_WIDTH; ++x, ++scan) {
-                        const auto c = col(*vic_frame++);
-                        *scan = c;
-                        *(scan + VIC_II::FRAME_WIDTH) = c;
-                    }
-                    scan += VIC_II::FRAME_WIDTH;
-                }
-
-                const auto bytes_per_row = 1 * (bytes_per_pixel * VIC_II::FRAME_WIDTH);
-                SDL_UpdateTexture(frame.texture, 0, (void*)frame.pixels, bytes_per_row);
-            };
-            break;
-        case 2: // {2, 2}
-            draw = [&](const u8* vic_frame) {
-                u32* scan = frame.pixels;
-
-                for (int y = 0; y < VIC_II::FRAME_HEIGHT; ++y) {
-                    for (int x = 0; x < VIC_II::FRAME_WIDTH; ++x) {
-                        const auto c = col(vic_frame[x]);
-                        *scan++ = c;
-                        *scan++ = c;
-                    }
-                    for (int x = 0; x < VIC_II::FRAME_WIDTH; ++x) {
-                        const auto c = col(vic_frame[x]);
-                        *scan++ = c;
-                        *scan++ = c;
-                    }
-                    vic_frame += VIC_II::FRAME_WIDTH;
-                }
-
-                const auto bytes_per_row = 2 * (bytes_per_pixel * VIC_II::FRAME_WIDTH);
-                SDL_UpdateTexture(frame.texture, 0, (void*)frame.pixels, bytes_per_row);
-            };
-            break;
-        case 3: // {3, 3}
-            draw = [&](const u8* vic_frame) {
-                u32* scan = frame.pixels;
-
-                auto draw_row = [&]() {
-                    for (int x = 0; x < VIC_II::FRAME_WIDTH; ++x) {
-                        const auto c = col(vic_frame[x]);
-                        *scan++ = c;
-                        *scan++ = c;
-                        *scan++ = c;
-                    }
-                };
-
-                for (int y = 0; y < VIC_II::FRAME_HEIGHT; ++y) {
-                    draw_row();
-                    draw_row();
-                    draw_row();
-                    vic_frame += VIC_II::FRAME_WIDTH;
-                }
-
-                const auto bytes_per_row = 3 * (bytes_per_pixel * VIC_II::FRAME_WIDTH);
-                SDL_UpdateTexture(frame.texture, 0, (void*)frame.pixels, bytes_per_row);
-            };
-            break;
+    px_w = px_sz[set.sharpness].w;
+    px_h = px_sz[set.sharpness].h;
+
+    redraw = true;
+}
+
+
+void Video_out::Frame::upload(const u8* vic_frame, const bool* changed_lines) {
+    frame.srcrect.w = VIC_II::FRAME_WIDTH * px_w;
+    frame.srcrect.h = VIC_II::FRAME_HEIGHT * px_h;
+
+    int y_from = 0;
+    int y_to = VIC_II::FRAME_HEIGHT;
+    if (!redraw) {
+        while (y_from < y_to && !changed_lines[y_from]) ++y_from;
+        while (y_to > y_from && !changed_lines[y_to - 1]) --y_to;
+        if (y_from == y_to) return; // no changes
+    }
+
+    const SDL_Rect rect{0, y_from * px_h, frame.srcrect.w, (y_to - y_from) * px_h};
+    void* pixels;
+    int pitch;
+    if (SDL_LockTexture(frame.texture, &rect, &pixels, &pitch) != 0) {
+        Log::error("Failed to SDL_LockTexture: %s", SDL_GetError());
+        redraw = true; // (the texture is behind)
+        return;
+    }
+
+    const auto bytes_per_row = frame.srcrect.w * bytes_per_pixel;
+    u8* row = (u8*)pixels;
+
+    const u8* line = vic_frame + y_from * VIC_II::FRAME_WIDTH;
+    for (int y = y_from; y < y_to; ++y, line += VIC_II::FRAME_WIDTH) {
+        const u8* first = row;
+        VIC_II::SIMD::to_rgb((u32*)row, line, palette, VIC_II::FRAME_WIDTH, px_w);
+        row += pitch;
+        for (int r = 1; r < px_h; ++r, row += pitch) std::memcpy(row, first, bytes_per_row);
     }
+
+    SDL_UnlockTexture(frame.texture);
+
+    redraw = false;
 }
 
 
@@ -447,7 +364,7 @@ void Video_out::Mask::upd(const Settings& set) {
 
 
 Video_out::~Video_out() {
-    SDL_DestroyRenderer(renderer);
+    if (renderer) SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
 }
 
@@ -490,7 +407,6 @@ void Video_out::upd_mode() {
 
         frame.frame.connect(renderer);
         mask.frame.connect(renderer);
-
     }
 
     switch (set.mode) {
@@ -527,14 +443,15 @@ void Video_out::upd_mode() {
         exit(1);
     }
 
-    const int new_vsync = double(sdl_mode.refresh_rate) == frame_rate_client ? 1 : 0;
+    const bool new_vsync = double(sdl_mode.refresh_rate) == frame_rate_client;
     if (new_vsync != vsync) {
         if (SDL_RenderSetVSync(renderer, new_vsync) == 0) vsync = new_vsync;
+        else Log::error("Failed to SDL_RenderSetVSync: %s", SDL_GetError());
     }
 
     Log::info("Video out: %dx%d, %d Hz (in: %.3f Hz ==> vsync: %d)",
                 sdl_mode.w, sdl_mode.h,
-                sdl_mode.refresh_rate, frame_rate_client, vsync);
+                sdl_mode.refresh_rate, frame_rate_client, int(vsync));
 
     mask.upd(set);
 
@@ -544,34 +461,52 @@ void Video_out::upd_mode() {
 }
 
 
+SDL_Rect Video_out::win_rect(const Settings& s) {
+    const auto aspect_ratio = s.aspect_ratio / 1000.0;
+    const auto window_scale = s.window_scale / 100.0;
+
+    const int w = aspect_ratio * (window_scale * VIC_II::FRAME_WIDTH);
+    const int h = window_scale * VIC_II::FRAME_HEIGHT;
+    return SDL_Rect{0, 0, w, h};
+}
+
+
 void Video_out::upd_dimensions() {
-    const auto aspect_ratio = set.aspect_ratio / 1000.0;
-    const auto window_scale = set.window_scale / 100.0;
+    if (set.mode == Mode::win) {
+        const auto r = win_rect(set);
+        win_w = r.w;
+        win_h = r.h;
+        SDL_SetWindowSize(window, win_w, win_h);
+    }
+
+    upd_rects();
+}
+
 
+void Video_out::upd_rects() {
     if (set.mode == Mode::win) {
-        const int w = aspect_ratio * (window_scale * VIC_II::FRAME_WIDTH);
-        const int h = window_scale * VIC_II::FRAME_HEIGHT;
-        SDL_SetWindowSize(window, w, h);
-        frame.frame.dstrect = SDL_Rect{0, 0, w, h};
-        mask.frame.srcrect = mask.frame.dstrect = SDL_Rect{0, 0, w, h};;
+        frame.frame.dstrect = win_rect(set);
+        mask.frame.srcrect = mask.frame.dstrect = frame.frame.dstrect;
     } else {
-        int win_w; int win_h;
-        SDL_GetRendererOutputSize(renderer, &win_w, &win_h);
-        int w = aspect_ratio * (((double)win_h / VIC_II::FRAME_HEIGHT) * VIC_II::FRAME_WIDTH);
-        if (w < win_w) {
-            frame.frame.dstrect.x = (win_w - w) / 2;
+        const auto aspect_ratio = set.aspect_ratio / 1000.0;
+
+        int out_w; int out_h;
+        SDL_GetRendererOutputSize(renderer, &out_w, &out_h);
+        int w = aspect_ratio * (((double)out_h / VIC_II::FRAME_HEIGHT) * VIC_II::FRAME_WIDTH);
+        if (w < out_w) {
+            frame.frame.dstrect.x = (out_w - w) / 2;
             frame.frame.dstrect.y = 0;
             frame.frame.dstrect.w = w;
-            frame.frame.dstrect.h = win_h;
+            frame.frame.dstrect.h = out_h;
         } else {
-            int h =  (((double)win_w / VIC_II::FRAME_WIDTH) * VIC_II::FRAME_HEIGHT) / aspect_ratio;
+            int h =  (((double)out_w / VIC_II::FRAME_WIDTH) * VIC_II::FRAME_HEIGHT) / aspect_ratio;
             frame.frame.dstrect.x = 0;
-            frame.frame.dstrect.y = (win_h - h) / 2;
-            frame.frame.dstrect.w = win_w;
+            frame.frame.dstrect.y = (out_h - h) / 2;
+            frame.frame.dstrect.w = out_w;
             frame.frame.dstrect.h = h;
         }
 
-        mask.frame.srcrect = mask.frame.dstrect = SDL_Rect{0, 0, win_w, win_h};;
+        mask.frame.srcrect = mask.frame.dstrect = SDL_Rect{0, 0, out_w, out_h};;
     }
 
     SDL_RenderClear(renderer);
@@ -581,8 +516,8 @@ void Video_out::upd_dimensions() {
 void Video_out::resize_window(int w, int h) {
     if (set.mode != Mode::win) return;
 
-    const int old_w = frame.frame.dstrect.w;
-    const int old_h = frame.frame.dstrect.h;
+    const int old_w = win_w;
+    const int old_h = win_h;
 
     if (w != old_w && h != old_h) {
         // pick the bigger change (keeping aspect ratio)
@@ -613,6 +548,26 @@ void Video_out::resize_window(int w, int h) {
 }
 
 
+void Audio_out::flush() {
+    if (!dev) return;
+
+    SDL_LockAudioDevice(dev); // (the callback is the consumer)
+    i16 discard[256];
+    while (ring->read(discard, 256)) {}
+    SDL_UnlockAudioDevice(dev);
+}
+
+
+void Audio_out::callback(void* audio_out, Uint8* stream, int len) {
+    auto& ring = *static_cast<Audio_out*>(audio_out)->ring;
+
+    i16* to = (i16*)stream;
+    const int sz = len / bytes_per_sample;
+    const int n = ring.read(to, sz);
+    std::fill(to + n, to + sz, 0); // underrun --> silence
+}
+
+
 u16 Audio_out::config(u16 buf_sz) {
     SDL_AudioSpec want;
     SDL_AudioSpec have;
@@ -629,6 +584,8 @@ u16 Audio_out::config(u16 buf_sz) {
     want.format = AUDIO_S16LSB;
     want.channels = 1;
     want.samples = buf_sz;
+    want.callback = callback;
+    want.userdata = this;
 
     dev = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
     if (dev == 0) {
@@ -648,3 +605,6 @@ u16 Audio_out::config(u16 buf_sz) {
 
 
 _SDL& _sdl = _SDL::instance();
+
+
+#endif // HEADLESS
@@ -1,10 +1,16 @@
 #ifndef HOST_H_INCLUDED
 #define HOST_H_INCLUDED
 
+#ifdef HEADLESS
+#include "host_headless.h"
+#else
+
 #include <SDL.h>
+#include <memory>
 #include "common.h"
 #include "utils.h"
 #include "menu.h"
+#include "host_input.h"
 
 
 
@@ -14,21 +20,13 @@ namespace Host {
 // TODO: paddles/lightpen
 class Input {
 public:
-    struct Handlers {
-        Sig_key keyboard;
-        Sig_key controller_1;
-        Sig_key controller_2;
-        Sig1<u8> restore;
-        Sig_key sys;
-        Sig1<const char*> filedrop;
-        Sig2<int, int> window_resized;
-    };
+    using Handlers = Input_handlers;
 
-    static const u8 JOY_ID_BIT = 0x10; // included in the joy. key code
+    static const u8 JOY_ID_BIT = Key_dispatch::JOY_ID_BIT;
 
     void poll();
 
-    void swap_joysticks();
+    void swap_joysticks() { keys.swap_joysticks(); }
 
     Input(Handlers& handlers_);
 
@@ -38,42 +36,41 @@ public:
     }
 
 private:
-    static u8 KC_LU_TBL[];
+    static const u8 KC_LU_TBL[];
     static const u8 SC_LU_TBL[];
     static const u8 SC_RALT_LU_TBL[];
 
+    std::vector<u8> kc_lu_tbl; // own copy, since shift keys get disabled/enabled on the fly
+
     SDL_Event sdl_ev;
 
     Handlers& handlers;
 
-    Sig_key* joy_handler[2];
+    Key_dispatch keys;
 
     SDL_Joystick* sdl_joystick[2] = { nullptr, nullptr }; // TODO: struct these togeteher
     SDL_JoystickID sdl_joystick_id[2];
 
     u16 sh_l_idx = 0;
     u16 sh_r_idx = 0;
-    u16 sh_r_down = 0x00; // bit map - keeps track of 'auto shifted' keys
 
     void handle_key(u8 down) {
         // auto s=sdl_ev.key.keysym; Log::info("sym sc mod: %d %d %d %d", s.sym, s.scancode, s.mod, down);
         const u8 code = translate_sdl_key();
-        output_key(code, down);
+        keys.output(code, down);
     }
 
     u8 translate_sdl_key();
-    void output_key(u8 code, u8 down);
     void handle_joy_axis();
 
     void handle_joy_btn(u8 down) {
         SDL_JoyButtonEvent& joy_ev = sdl_ev.jbutton;
-        Sig_key& output = get_joy_output(joy_ev.which);
-        output(Key_code::Joystick::jb, down);
+        output_joy(joy_ev.which, Key_code::Joystick::jb, down);
     }
 
-    Sig_key& get_joy_output(SDL_JoystickID which) {
-        int joy_idx = (which == sdl_joystick_id[0]) ? 0 : 1;
-        return *(joy_handler[joy_idx]);
+    void output_joy(SDL_JoystickID which, u8 code, u8 down) {
+        const u8 joy_id = (which == sdl_joystick_id[0]) ? 0 : JOY_ID_BIT;
+        keys.output(Key_code::GJ | joy_id | code, down);
     }
 
     void handle_win_ev() {
@@ -98,15 +95,15 @@ private:
     void set_shift_lock() {
         const bool down = SDL_GetModState() & KMOD_CAPS;
         // disable/enable left shift
-        KC_LU_TBL[sh_l_idx] = down
+        kc_lu_tbl[sh_l_idx] = down
             ? (Key_code::Keyboard)Key_code::System::nop
             : Key_code::Keyboard::sh_l;
 
         handlers.keyboard(Key_code::Keyboard::sh_l, down);
     }
 
-    void disable_sh_r() { KC_LU_TBL[sh_r_idx] = Key_code::System::nop; }
-    void enable_sh_r()  { KC_LU_TBL[sh_r_idx] = Key_code::Keyboard::sh_r; }
+    void disable_sh_r() { kc_lu_tbl[sh_r_idx] = Key_code::System::nop; }
+    void enable_sh_r()  { kc_lu_tbl[sh_r_idx] = Key_code::Keyboard::sh_r; }
 
 };
 
@@ -143,9 +140,10 @@ public:
     Video_out(const double& frame_rate_client_) : frame_rate_client(frame_rate_client_) {}
     ~Video_out();
 
-    void put(const u8* vic_frame);
+    // converts & uploads the changed lines (as noted by the VIC), and presents
+    void put(const u8* vic_frame, const bool* changed_lines);
 
-    void flip() { SDL_RenderPresent(renderer); }
+    void flip() { present(); }
 
     void toggle_fullscr_win() { // TODO: cycle through presets instead --> TODO: presets...
         set.mode = (set.mode == Mode::win) ? Mode::fullscr_win : Mode::win;
@@ -172,7 +170,7 @@ private:
         SDL_Texture* texture = nullptr;
         SDL_Rect srcrect = {0, 0, 0, 0};
         SDL_Rect dstrect = {0, 0, 0, 0};
-        u32* pixels = nullptr;
+        u32* pixels = nullptr; // (static textures only)
 
         SDL_frame(int max_w_, int max_h_, SDL_TextureAccess ta_, SDL_BlendMode bm_);
         ~SDL_frame();
@@ -190,16 +188,19 @@ private:
         void upd_palette(const Settings& set);
         void upd_sharpness(const Settings& set);
 
-        void put(const u8* vic_frame, SDL_Renderer* r) {
-            draw(vic_frame);
-            frame.copy(r);
-        }
+        /*  The changed lines (or all, if 'redraw') are converted straight into the texture,
+            locked once for the span of them. The locked pixels are write-only, so the
+            unchanged lines within the span get converted too.
+        */
+        void upload(const u8* vic_frame, const bool* changed_lines);
 
-        u32 col(const u8 vic_pixel) { return palette[vic_pixel & 0xf]; } // TODO: do '&' here? (or in VIC?)}
+        u8 px_w = 1; // host pixels per VIC pixel
+        u8 px_h = 1;
 
-        std::function<void (const u8* )> draw;
+        bool redraw = true; // all lines to be uploaded (palette/sharpness changed)
 
         u32 palette[16];
+
         SDL_frame frame{max_w, max_h, SDL_TEXTUREACCESS_STREAMING, SDL_BLENDMODE_NONE};
     };
 
@@ -219,14 +220,21 @@ private:
 
     void upd_mode();
     void upd_dimensions();
+    void upd_rects();
     void resize_window(int w, int h);
+    void present();
+
+    static SDL_Rect win_rect(const Settings& s); // windowed mode
 
     const double& frame_rate_client;
 
     Settings set;
 
     SDL_DisplayMode sdl_mode = { 0, 0, 0, 0, 0 };
-    int vsync = 0;
+    bool vsync = false;
+
+    int win_w = 0; // as set by 'upd_dimensions()' (windowed mode)
+    int win_h = 0;
 
     SDL_Window* window = nullptr;
     SDL_Renderer* renderer = nullptr;
@@ -234,6 +242,7 @@ private:
     Frame frame;
     Mask mask;
 
+
     std::vector<Menu::Knob> menu_items{
         //name           connected setting   notify
         {"Mode",         set.mode,           [&](){ upd_mode(); }},
@@ -262,20 +271,27 @@ public:
 
     u16 config(u16 buf_sz);
 
-    int put(const i16* chunk, u32 sz) {
+    int put(const i16* chunk, u32 sz) { // returns the level (samples buffered)
         if (dev) {
-            SDL_QueueAudio(dev, chunk, sz * bytes_per_sample);
-            return SDL_GetQueuedAudioSize(dev) / bytes_per_sample;
+            ring->write(chunk, sz);
+            return ring->size();
         }
 
         return 0;
     }
 
-    void flush() { SDL_ClearQueuedAudio(dev); }
+    void flush();
 
 private:
+    // Written by 'put()', read by the SDL audio callback (no locking, no allocations).
+    // ~370 ms, i.e. plenty for the 'clock speed control' of the client.
+    using Ring = SPSC_ring<i16, 0x4000>;
+
+    static void callback(void* audio_out, Uint8* stream, int len);
+
     SDL_AudioDeviceID dev = 0;
 
+    std::unique_ptr<Ring> ring{std::make_unique<Ring>()};
 };
 
 
@@ -314,4 +330,6 @@ extern _SDL& _sdl;
 
 }
 
+#endif // HEADLESS
+
 #endif // HOST_H_INCLUDED
@@ -0,0 +1,214 @@
+#ifdef HEADLESS
+
+#include <fstream>
+#include <algorithm>
+#include <sstream>
+#include "host.h"
+
+
+
+using namespace Host;
+
+using kb = Key_code::Keyboard;
+using ke = Key_code::Keyboard_ext;
+using js = Key_code::Joystick;
+using sy = Key_code::System;
+
+
+static const u8 J1 = 0x00;
+static const u8 J2 = Input::JOY_ID_BIT;
+
+
+static const std::pair<const char*, u8> KEY_NAMES[] = {
+    {"r_stp", kb::r_stp}, {"q", kb::q},         {"cmdre", kb::cmdre}, {"space", kb::space},
+    {"2", kb::num_2},     {"ctrl", kb::ctrl},   {"ar_l", kb::ar_l},   {"1", kb::num_1},
+    {"div", kb::div},     {"ar_up", kb::ar_up}, {"eq", kb::eq},       {"sh_r", kb::sh_r},
+    {"home", kb::home},   {"s_col", kb::s_col}, {"mul", kb::mul},     {"pound", kb::pound},
+    {"comma", kb::comma}, {"at", kb::at},       {"colon", kb::colon}, {"dot", kb::dot},
+    {"minus", kb::minus}, {"l", kb::l},         {"p", kb::p},         {"plus", kb::plus},
+    {"n", kb::n},         {"o", kb::o},         {"k", kb::k},         {"m", kb::m},
+    {"0", kb::num_0},     {"j", kb::j},         {"i", kb::i},         {"9", kb::num_9},
+    {"v", kb::v},         {"u", kb::u},         {"h", kb::h},         {"b", kb::b},
+    {"8", kb::num_8},     {"g", kb::g},         {"y", kb::y},         {"7", kb::num_7},
+    {"x", kb::x},         {"t", kb::t},         {"f", kb::f},         {"c", kb::c},
+    {"6", kb::num_6},     {"d", kb::d},         {"r", kb::r},         {"5", kb::num_5},
+    {"sh_l", kb::sh_l},   {"e", kb::e},         {"s", kb::s},         {"z", kb::z},
+    {"4", kb::num_4},     {"a", kb::a},         {"w", kb::w},         {"3", kb::num_3},
+    {"crs_d", kb::crs_d}, {"f5", kb::f5},       {"f3", kb::f3},       {"f1", kb::f1},
+    {"f7", kb::f7},       {"crs_r", kb::crs_r}, {"ret", kb::ret},     {"del", kb::del},
+
+    {"crs_u", ke::crs_u}, {"f6", ke::f6},       {"f4", ke::f4},       {"f2", ke::f2},
+    {"f8", ke::f8},       {"crs_l", ke::crs_l}, {"s_lck", ke::s_lck}, {"rstre", ke::rstre},
+
+    {"j1u", J1|js::ju},   {"j1d", J1|js::jd},   {"j1l", J1|js::jl},   {"j1r", J1|js::jr},
+    {"j1b", J1|js::jb},
+    {"j2u", J2|js::ju},   {"j2d", J2|js::jd},   {"j2l", J2|js::jl},   {"j2r", J2|js::jr},
+    {"j2b", J2|js::jb},
+
+    {"rst_cold", sy::rst_cold}, {"rst_warm", sy::rst_warm}, {"save_state", sy::save_state},
+    {"exp_btn_1", sy::exp_btn_1}, {"rot_dsk", sy::rot_dsk}, {"tgl_wp", sy::tgl_wp},
+    {"rewind", sy::rewind}, {"rec_input", sy::rec_input}, {"shutdown", sy::shutdown},
+};
+
+
+static Maybe<u8> key_code(const std::string& name) {
+    for (const auto& [n, code] : KEY_NAMES) if (name == n) return code;
+    return {};
+}
+
+
+// ascii --> (key code, shifted)
+static Maybe<std::pair<u8, bool>> ascii_key(char ch) {
+    static constexpr char shifted_digits[] = "!\"#$%&'()";
+
+    ch = as_lower(std::string(1, ch))[0];
+
+    if (ch >= 'a' && ch <= 'z') {
+        if (auto code = key_code(std::string(1, ch)); code) return {{*code, false}};
+    }
+    if (ch >= '0' && ch <= '9') {
+        if (auto code = key_code(std::string(1, ch)); code) return {{*code, false}};
+    }
+    for (int d = 0; shifted_digits[d]; ++d) {
+        if (ch == shifted_digits[d]) return {{*key_code(std::to_string(d + 1)), true}};
+    }
+
+    switch (ch) {
+        case ' ':  return {{kb::space, false}};
+        case '\n': return {{kb::ret,   false}};
+        case ',':  return {{kb::comma, false}};
+        case '.':  return {{kb::dot,   false}};
+        case ':':  return {{kb::colon, false}};
+        case ';':  return {{kb::s_col, false}};
+        case '=':  return {{kb::eq,    false}};
+        case '+':  return {{kb::plus,  false}};
+        case '-':  return {{kb::minus, false}};
+        case '*':  return {{kb::mul,   false}};
+        case '/':  return {{kb::div,   false}};
+        case '@':  return {{kb::at,    false}};
+        case '^':  return {{kb::ar_up, false}};
+        case '<':  return {{kb::comma, true}};
+        case '>':  return {{kb::dot,   true}};
+        case '?':  return {{kb::div,   true}};
+        case '[':  return {{kb::colon, true}};
+        case ']':  return {{kb::s_col, true}};
+    }
+
+    return {};
+}
+
+
+bool Input::load_script(const std::string& filepath) {
+    std::ifstream f(filepath);
+    if (!f) {
+        Log::error("Unable to open script: '%s'", filepath.c_str());
+        return false;
+    }
+
+    int line_n = 0;
+    for (std::string line; std::getline(f, line); ) {
+        ++line_n;
+        if (!parse(line)) {
+            Log::error("%s:%d: invalid script line: '%s'", filepath.c_str(), line_n, line.c_str());
+            return false;
+        }
+    }
+
+    Log::info("Script loaded: '%s' (%d events)", filepath.c_str(), int(script.size()));
+
+    return true;
+}
+
+
+bool Input::parse(const std::string& line) {
+    std::istringstream ls(line);
+
+    std::string frame_str;
+    if (!(ls >> frame_str) || frame_str[0] == '#') return true; // empty/comment
+
+    u64 frame;
+    try { frame = std::stoull(frame_str); } catch (...) { return false; }
+    const u64 at_cycle = frame * FRAME_CYCLE_COUNT;
+
+    std::string cmd;
+    ls >> cmd;
+
+    auto rest = [&]() {
+        std::string r;
+        std::getline(ls >> std::ws, r);
+        return r;
+    };
+
+    if (cmd == "type") {
+        type(at_cycle, replace(rest(), "\\n", "\n"));
+    } else if (cmd == "key") {
+        std::string name, state;
+        ls >> name >> state;
+        const auto code = key_code(as_lower(name));
+        if (!code) return false;
+        if (state == "down" || state == "up") {
+            push({at_cycle, Event::key, *code, state == "down", ""});
+        } else if (state.empty()) {
+            push({at_cycle, Event::key, *code, true, ""});
+            push({at_cycle + FRAME_CYCLE_COUNT, Event::key, *code, false, ""});
+        } else {
+            return false;
+        }
+    } else if (cmd == "restore") {
+        push({at_cycle, Event::key, ke::rstre, true, ""});
+        push({at_cycle + FRAME_CYCLE_COUNT, Event::key, ke::rstre, false, ""});
+    } else if (cmd == "drop") {
+        const auto path = rest();
+        if (path.empty()) return false;
+        push({at_cycle, Event::drop, sy::nop, false, path});
+    } else if (cmd == "quit") {
+        push_quit(at_cycle);
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+
+void Input::type(u64 at_cycle, const std::string& text) {
+    // a key is held down for a frame, and released for a frame (the kernal scans
+    // the keyboard 60 times/s, so every key press gets noticed)
+    static constexpr u64 hold = FRAME_CYCLE_COUNT;
+
+    for (const char ch : text) {
+        if (auto key = ascii_key(ch); key) {
+            const auto [code, shifted] = *key;
+            if (shifted) push({at_cycle, Event::key, kb::sh_l, true, ""});
+            push({at_cycle, Event::key, code, true, ""});
+            push({at_cycle + hold, Event::key, code, false, ""});
+            if (shifted) push({at_cycle + hold, Event::key, kb::sh_l, false, ""});
+            at_cycle += 2 * hold;
+        } else {
+            Log::error("Unable to type: '%c'", ch);
+        }
+    }
+}
+
+
+void Input::push(const Event& ev) {
+    auto pos = std::upper_bound(script.begin(), script.end(), ev.cycle,
+                    [](u64 cycle, const Event& e) { return cycle < e.cycle; });
+    script.insert(pos, ev);
+}
+
+
+void Input::poll() {
+    while (!script.empty() && script.front().cycle <= system_cycle) {
+        const Event ev = script.front();
+        script.pop_front();
+
+        switch (ev.target) {
+            case Event::key:  keys.output(ev.code, ev.down);          break;
+            case Event::drop: handlers.filedrop(ev.path.c_str());     break;
+        }
+    }
+}
+
+
+#endif // HEADLESS
@@ -0,0 +1,114 @@
+#ifndef HOST_HEADLESS_H_INCLUDED
+#define HOST_HEADLESS_H_INCLUDED
+
+#include <deque>
+#include "common.h"
+#include "utils.h"
+#include "menu.h"
+#include "host_input.h"
+
+
+
+// Headless 'host': null video/audio sinks & a scripted input source (no SDL)
+namespace Host {
+
+
+class Input {
+public:
+    using Handlers = Input_handlers;
+
+    static const u8 JOY_ID_BIT = Key_dispatch::JOY_ID_BIT;
+
+    struct Event {
+        enum Target : u8 { key, drop };
+
+        u64 cycle;
+        Target target;
+        u8 code; // Key_code (any group)
+        u8 down;
+        std::string path; // for 'drop'
+    };
+
+    /*  Script format (one event per line, times in frames, '#' starts a comment):
+            <frame> type <text>        -- type text ('\n' --> return)
+            <frame> key <name> [down|up] -- without 'down/up' --> press & release
+            <frame> restore
+            <frame> drop <path>        -- as if a file was dropped on the window
+            <frame> quit
+    */
+    bool load_script(const std::string& filepath);
+
+    void push(const Event& ev); // keeps the script ordered by cycle
+    void type(u64 at_cycle, const std::string& text);
+    void push_quit(u64 at_cycle) { push({at_cycle, Event::key, Key_code::System::shutdown, true, ""}); }
+
+    void poll();
+
+    void swap_joysticks() { keys.swap_joysticks(); }
+
+    Input(Handlers& handlers_, const u64& system_cycle_)
+        : handlers(handlers_), system_cycle(system_cycle_), keys(handlers_) {}
+
+private:
+    Handlers& handlers;
+
+    const u64& system_cycle;
+
+    Key_dispatch keys;
+
+    std::deque<Event> script;
+
+    bool parse(const std::string& line);
+};
+
+
+class Video_out {
+public:
+    Menu::Group settings_menu() { return { "Video", menu_items }; }
+
+    Video_out(const double& frame_rate_client_) { UNUSED(frame_rate_client_); }
+
+    void put(const u8* vic_frame, const bool* changed_lines) { UNUSED2(vic_frame, changed_lines); }
+
+    void flip() {}
+
+    void toggle_fullscr_win() {}
+
+    Sig2<int, int> window_resized {
+        [](int w, int h) { UNUSED2(w, h); }
+    };
+
+    void reconfig() {}
+
+    bool v_synced() const { return false; }
+
+private:
+    std::vector<Menu::Knob> menu_items;
+};
+
+
+class Audio_out {
+public:
+    static constexpr int bytes_per_sample = 2;
+
+    u16 config(u16 buf_sz_) { buf_sz = buf_sz_; return buf_sz; }
+
+    int put(const i16* chunk, u32 sz) {
+        if (capture) capture->insert(capture->end(), chunk, chunk + sz);
+        // report a steady 'mid-window' level --> no clock speed steering by the client
+        return 4 * buf_sz;
+    }
+
+    void flush() {}
+
+    std::vector<i16>* capture = nullptr; // if set, all output is appended to it
+
+private:
+    u16 buf_sz = 0;
+
+};
+
+
+}
+
+#endif // HOST_HEADLESS_H_INCLUDED
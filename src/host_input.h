@@ -0,0 +1,110 @@
+#ifndef HOST_INPUT_H_INCLUDED
+#define HOST_INPUT_H_INCLUDED
+
+#include <utility>
+#include "common.h"
+
+
+
+// The host independent part of the input: key codes (any group) --> the input handlers
+namespace Host {
+
+
+struct Input_handlers {
+    Sig_key keyboard;
+    Sig_key controller_1;
+    Sig_key controller_2;
+    Sig1<u8> restore;
+    Sig_key sys;
+    Sig1<const char*> filedrop;
+    Sig2<int, int> window_resized;
+};
+
+
+/*  The extended keys (crs_u, f2, ...) are output as their 'real' keys, with the right
+    shift held down for as long as any of them is down.
+    Hooks for the host:
+        auto_shift: called after the right shift got pressed/released automatically
+        shift_lock: shift lock key down/up (default: left shift down/up)
+*/
+class Key_dispatch {
+public:
+    static const u8 JOY_ID_BIT = 0x10; // included in the joy. key code
+
+    Sig1<bool> auto_shift{[](bool) {}};
+    Sig1<u8> shift_lock{[this](u8 down) { handlers.keyboard(Key_code::Keyboard::sh_l, down); }};
+
+    Key_dispatch(Input_handlers& handlers_)
+        : handlers(handlers_), joy_handler{ &handlers_.controller_1, &handlers_.controller_2 } {}
+
+    void output(u8 code, u8 down) {
+        using kb = Key_code::Keyboard;
+        using ke = Key_code::Keyboard_ext;
+
+        switch (code >> 6) {
+            case Key_code::Group::keyboard:
+                handlers.keyboard(code, down);
+                break;
+
+            case Key_code::Group::keyboard_ext:
+                switch (code) {
+                    case ke::crs_u: case ke::f6: case ke::f4:
+                    case ke::f2:    case ke::f8: case ke::crs_l: {
+                        // 6 of these are actually used (for crs_u, f6, f4, f2, f8, crs_l)
+                        static const u8 BIT[] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+
+                        if (down) {
+                            if (sh_r_down == 0x00) {
+                                // first 'auto shifted' key held down --> set 'right shift' down
+                                handlers.keyboard(kb::sh_r, true);
+                                auto_shift(true);
+                            }
+                            sh_r_down |= BIT[code & 0x7]; // keep track of key presses
+                        } else {
+                            sh_r_down &= (~BIT[code & 0x7]);
+                            if (sh_r_down == 0x00) {
+                                // last 'auto shifted' key released --> set 'right shift' up
+                                handlers.keyboard(kb::sh_r, false);
+                                auto_shift(false);
+                            }
+                        }
+
+                        const u8 kc_offset = ke::crs_l - kb::crs_r;
+                        handlers.keyboard(code - kc_offset, down); // send the corresponding 'real' code
+
+                        break;
+                    }
+                    case ke::s_lck: shift_lock(down);       break;
+                    case ke::rstre: handlers.restore(down); break;
+                }
+                break;
+
+            case Key_code::Group::joystick: {
+                auto id = code & JOY_ID_BIT ? 1 : 0;
+                (*joy_handler[id])(code & 0x7, down);
+                break;
+            }
+
+            case Key_code::Group::system:
+                handlers.sys(code, down);
+                break;
+        }
+    }
+
+    void swap_joysticks() {
+        std::swap(joy_handler[0], joy_handler[1]);
+        Log::info("Joysticks swapped");
+    }
+
+private:
+    Input_handlers& handlers;
+
+    Sig_key* joy_handler[2];
+
+    u16 sh_r_down = 0x00; // bit map - keeps track of 'auto shifted' keys
+};
+
+
+} // namespace Host
+
+#endif // HOST_INPUT_H_INCLUDED
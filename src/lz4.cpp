@@ -0,0 +1,120 @@
+#include "lz4.h"
+
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+
+
+static constexpr std::size_t min_match     = 4;
+static constexpr std::size_t last_literals = 5;  // the block always ends with these
+static constexpr std::size_t mf_limit      = 12; // no match may start after 'end - mf_limit'
+static constexpr std::size_t max_offset    = 0xffff;
+static constexpr int hash_bits = 14;
+
+
+static inline u32 read32(const u8* p) { u32 v; std::memcpy(&v, p, 4); return v; }
+
+static inline u32 hash(u32 seq) { return (seq * 2654435761u) >> (32 - hash_bits); }
+
+
+static void put_len(Bytes& to, std::size_t len) { // the part not fitting to the token nibble
+    for (; len >= 0xff; len -= 0xff) to.push_back(0xff);
+    to.push_back(len);
+}
+
+
+static void put_sequence(Bytes& to, const u8* lit, std::size_t lit_len, std::size_t offset, std::size_t match_len) {
+    const bool last = (match_len == 0);
+    const std::size_t ml = last ? 0 : match_len - min_match;
+
+    to.push_back(((lit_len < 15 ? lit_len : 15) << 4) | (ml < 15 ? ml : 15));
+    if (lit_len >= 15) put_len(to, lit_len - 15);
+    to.insert(to.end(), lit, lit + lit_len);
+
+    if (last) return;
+
+    to.push_back(offset);
+    to.push_back(offset >> 8);
+    if (ml >= 15) put_len(to, ml - 15);
+}
+
+
+void LZ4::compress(const u8* data, std::size_t size, Bytes& to) {
+    const u8* ip = data;
+    const u8* anchor = data;
+    const u8* const end = data + size;
+
+    if (size > mf_limit) {
+        std::vector<u32> table(1 << hash_bits, 0); // position of the last seen sequence (per hash)
+        const u8* const match_limit = end - last_literals;
+
+        while (ip < end - mf_limit) {
+            const u32 seq = read32(ip);
+            const u32 h = hash(seq);
+            const u8* ref = data + table[h];
+            table[h] = ip - data;
+
+            if (ref >= ip || std::size_t(ip - ref) > max_offset || read32(ref) != seq) {
+                ++ip;
+                continue;
+            }
+
+            // extend backwards (over the pending literals) & forwards
+            while (ip > anchor && ref > data && ip[-1] == ref[-1]) { --ip; --ref; }
+            std::size_t len = min_match;
+            while (ip + len < match_limit && ip[len] == ref[len]) ++len;
+
+            put_sequence(to, anchor, ip - anchor, ip - ref, len);
+
+            ip += len;
+            anchor = ip;
+        }
+    }
+
+    put_sequence(to, anchor, end - anchor, 0, 0);
+}
+
+
+bool LZ4::decompress(const u8* data, std::size_t size, u8* to, std::size_t to_size) {
+    const u8* ip = data;
+    const u8* const end = data + size;
+    u8* op = to;
+    u8* const op_end = to + to_size;
+
+    auto get_len = [&](std::size_t& len) {
+        for (u8 b = 0xff; b == 0xff; len += b) {
+            if (ip == end) return false;
+            b = *ip++;
+        }
+        return true;
+    };
+
+    while (ip < end) {
+        const u8 token = *ip++;
+
+        std::size_t lit_len = token >> 4;
+        if (lit_len == 15 && !get_len(lit_len)) return false;
+        if (lit_len > std::size_t(end - ip) || lit_len > std::size_t(op_end - op)) return false;
+        std::copy(ip, ip + lit_len, op);
+        ip += lit_len;
+        op += lit_len;
+
+        if (ip == end) break; // the last sequence (literals only)
+
+        if (end - ip < 2) return false;
+        const std::size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > std::size_t(op - to)) return false;
+
+        std::size_t match_len = token & 0xf;
+        if (match_len == 15 && !get_len(match_len)) return false;
+        match_len += min_match;
+        if (match_len > std::size_t(op_end - op)) return false;
+
+        const u8* ref = op - offset;
+        for (std::size_t i = 0; i < match_len; ++i) *op++ = *ref++; // may overlap
+    }
+
+    return op == op_end;
+}
@@ -0,0 +1,22 @@
+#ifndef LZ4_H_INCLUDED
+#define LZ4_H_INCLUDED
+
+#include "common.h"
+
+
+/*  Minimal (greedy, single pass) compressor for the LZ4 block format:
+        https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+    Fast enough to be used on every state save (most of the state is either zeroes or
+    highly repetitive).
+*/
+namespace LZ4 {
+
+void compress(const u8* data, std::size_t size, Bytes& to); // appends to 'to'
+
+// 'to_size' must be the exact decompressed size
+bool decompress(const u8* data, std::size_t size, u8* to, std::size_t to_size);
+
+} // namespace LZ4
+
+
+#endif // LZ4_H_INCLUDED
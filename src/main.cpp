@@ -3,13 +3,77 @@
 #include "dbg.h"
 #include "system.h"
 #include "test.h"
+#ifdef HEADLESS
+#include "batch.h"
+#endif
+#ifdef BENCH
+#include "bench.h"
+#endif
 
 
 
 void test();
 
 
-void run_c64() {
+#ifdef HEADLESS
+// usage: c64_emu_headless [-f <frames>] [-s <script>] [-n] [-c] [-l] [-p] [-r <MB>] [-i <file>] [file...]
+//   -f: quit after <frames> frames
+//   -s: input script (see 'host_headless.h' for the format)
+//   -n: no drive (1541 powered off)
+//   -c: no CPU run-ahead (plain per cycle stepping, e.g. for comparison)
+//   -l: no VIC line batching (per cycle output, e.g. for comparison)
+//   -p: no VIC pixel output (faster, if the screen is of no interest)
+//   -r: rewind buffer of <MB> megabytes (the 'rewind' key steps back, see 'Rewind::Buffer')
+//   -i: record the input to <file> (an input log, replayed when 'dropped', see 'Files::Input_log')
+//   file(s): 'dropped' at frame 0
+//
+// test: c64_emu_headless -t
+//   (regression checks, see 'test.h')
+//
+// batch: c64_emu_headless -b <job list> [-o <out dir>] [-j <threads>]
+//   (see 'batch.h' for the job list format)
+bool setup_headless(System::C64& c64, int argc, char** argv) {
+    auto& input = c64.input();
+
+    for (int a = 1; a < argc; ++a) {
+        const std::string arg = argv[a];
+        if (arg == "-f" && (a + 1) < argc) {
+            input.push_quit(std::stoull(argv[++a]) * FRAME_CYCLE_COUNT);
+        } else if (arg == "-s" && (a + 1) < argc) {
+            if (!input.load_script(argv[++a])) return false;
+        } else if (arg == "-n") {
+            c64.drive_power(false);
+        } else if (arg == "-c") {
+            c64.cpu_run_ahead(false);
+        } else if (arg == "-l") {
+            c64.vic_line_batching(false);
+        } else if (arg == "-p") {
+            c64.vic_pixel_output(false);
+        } else if (arg == "-r" && (a + 1) < argc) {
+            c64.rewind_buffer(std::stoi(argv[++a]));
+        } else if (arg == "-i" && (a + 1) < argc) {
+            c64.record_input(argv[++a]);
+        } else if (arg[0] != '-') {
+            input.push({0, Host::Input::Event::drop, Key_code::System::nop, false, arg});
+        } else {
+            Log::error("Unknown argument: '%s'", arg.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+#endif
+
+
+int run_c64(int argc, char** argv) {
+#ifdef HEADLESS
+    if (argc == 2 && std::string(argv[1]) == "-t") {
+        const bool pass = Test::run_rewind_test() & Test::run_changed_lines_test(); // (both run)
+        return pass ? 0 : 1;
+    }
+#endif
+
     State::System::ROM roms{};
 
     auto read_roms = [&]() -> bool {
@@ -19,21 +83,51 @@ void run_c64() {
                     && (read_file("data/c1541_roms/c1541.rom", roms.c1541) > 0);
     };
 
-    if (!read_roms()) return;
+    if (!read_roms()) return 1;
+
+#ifdef HEADLESS
+    if (argc > 2 && std::string(argv[1]) == "-b") {
+        std::string out_dir = "./_local/batch";
+        int thread_count = 0;
+        for (int a = 3; a < argc; ++a) {
+            const std::string arg = argv[a];
+            if (arg == "-o" && (a + 1) < argc) {
+                out_dir = argv[++a];
+            } else if (arg == "-j" && (a + 1) < argc) {
+                thread_count = std::stoi(argv[++a]);
+            } else {
+                Log::error("Invalid argument: '%s'", arg.c_str());
+                Log::error("usage: c64_emu_headless -b <job list> [-o <out dir>] [-j <threads>]");
+                return 1;
+            }
+        }
+        return Batch::run(argv[2], out_dir, roms, thread_count);
+    }
+#endif
 
     System::C64 c64(roms);
 
+#ifdef HEADLESS
+    if (!setup_headless(c64, argc, argv)) return 1;
+    c64.run(System::C64::Mode::headless);
+#else
+    UNUSED2(argc, argv);
     c64.run();
+#endif
+
+    return 0;
 }
 
 
 int main(int argv, char** args) {
-    UNUSED2(argv, args);
+#ifdef BENCH
+    return Bench::run(argv, args);
+#else
     //Test::run_6502_func_test();
     //Test::run_test_suite();
-    run_c64();
     //test();
-    return 0;
+    return run_c64(argv, args);
+#endif
 }
 
 
@@ -208,346 +208,364 @@ void MOS6502::Core::set_irq(bool act) {
 // **************** Single Byte Instructions ****************
 
 #define sb(opc, op) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         op; \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 1) \
 }
 
 // ******** Internal Execution On Memory Data ********
 
 #define ie_i(opc, op) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         op; \
         s.bus.a += 1; \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 1) \
 }
 
 #define ie_z(opc, op) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.pc = s.bus.a + 1; \
         s.bus.a = s.bus.d; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         op; \
         s.bus.a = s.pc; \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 2) \
 }
 
 #define ie_a(opc, op) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.aux = s.bus.d; \
         s.pc = s.bus.a + 2; \
         s.bus.a += 1; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = s.aux | (s.bus.d << 8); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         op; \
         s.bus.a = s.pc; \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 3) \
 }
 
 #define ie_izx(opc, op) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.pc = s.bus.a + 1; \
         s.bus.a = s.bus.d; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = zp(s.bus.a + s.x); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.aux = s.bus.d; \
         s.bus.a = zp(s.bus.a + 1); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         s.bus.a = s.aux | (s.bus.d << 8); \
-        break; \
-    case mc(opc, 4): \
+        return; \
+    MC(opc, 4): \
         op; \
         s.bus.a = s.pc; \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 5) \
 }
 
 #define ie_ai(opc, ireg, op) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.aux = s.bus.d + ireg; \
         s.pc = s.bus.a + 2; \
         s.bus.a += 1; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = (s.aux & 0xff) | (s.bus.d << 8); \
         s.mcc += (s.aux >> 8); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         op; \
         s.bus.a = s.pc; \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         s.bus.a += 0x100; \
-        break; \
-    case mc(opc, 4): \
+        return; \
+    MC(opc, 4): \
         op; \
         s.bus.a = s.pc; \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 5) \
 }
 
 #define ie_zi(opc, ireg, op) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.pc = s.bus.a + 1; \
         s.bus.a = s.bus.d; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = zp(s.bus.a + ireg); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         op; \
         s.bus.a = s.pc; \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 3) \
 }
 
 #define ie_izy(opc, op) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.pc = s.bus.a + 1; \
         s.bus.a = s.bus.d; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.aux = s.bus.d + s.y; \
         s.bus.a = zp(s.bus.a + 1); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.bus.a = (s.aux & 0xff) | (s.bus.d << 8); \
         s.mcc += (s.aux >> 8); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         op; \
         s.bus.a = s.pc; \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
-    case mc(opc, 4): \
+        return; \
+    MC(opc, 4): \
         s.bus.a += 0x100; \
-        break; \
-    case mc(opc, 5): \
+        return; \
+    MC(opc, 5): \
         op; \
         s.bus.a = s.pc; \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 6) \
 }
 
 // **************** Store Operations ****************
 
 #define st_z(opc, reg) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.pc = s.bus.a + 1; \
         s.bus.a = s.bus.d; \
         s.bus.d = reg; \
         s.bus(RW::w); \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = s.pc; \
         s.bus(RW::r); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 2) \
 }
 
 #define st_a(opc, reg) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.aux = s.bus.d; \
         s.pc = s.bus.a + 2; \
         s.bus.a += 1; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = s.aux | (s.bus.d << 8); \
         s.bus.d = reg; \
         s.bus(RW::w); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.bus.a = s.pc; \
         s.bus(RW::r); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 3) \
 }
 
 #define st_izx(opc, reg) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.pc = s.bus.a + 1; \
         s.bus.a = s.bus.d; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = zp(s.bus.a + s.x); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.aux = s.bus.d; \
         s.bus.a = zp(s.bus.a + 1); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         s.bus.a = s.aux | (s.bus.d << 8); \
         s.bus.d = reg; \
         s.bus(RW::w); \
-        break; \
-    case mc(opc, 4): \
+        return; \
+    MC(opc, 4): \
         s.bus.a = s.pc; \
         s.bus(RW::r); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 5) \
 }
 
 #define st_ai(opc, ireg) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.aux = s.bus.d + ireg; \
         s.pc = s.bus.a + 2; \
         s.bus.a += 1; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = (s.aux & 0xff) | (s.bus.d << 8); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.bus.a += (s.aux & 0x100); \
         s.bus.d = s.a; \
         s.bus(RW::w); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         s.bus.a = s.pc; \
         s.bus(RW::r); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 4) \
 }
 
 #define st_zi(opc, ireg, reg) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.pc = s.bus.a + 1; \
         s.bus.a = s.bus.d; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = zp(s.bus.a + ireg); \
         s.bus.d = reg; \
         s.bus(RW::w); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.bus.a = s.pc; \
         s.bus(RW::r); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 3) \
 }
 
 #define st_izy(opc) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.pc = s.bus.a + 1; \
         s.bus.a = s.bus.d; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.aux = s.bus.d + s.y; \
         s.bus.a = zp(s.bus.a + 1); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.bus.a = (s.aux & 0xff) | (s.bus.d << 8); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         s.bus.a += (s.aux & 0x100); \
         s.bus.d = s.a; \
         s.bus(RW::w); \
-        break; \
-    case mc(opc, 4): \
+        return; \
+    MC(opc, 4): \
         s.bus.a = s.pc; \
         s.bus(RW::r); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 5) \
 }
 
 // **************** Read-Modify-Write -operations ****************
 
 #define rmw_z(opc, op) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.pc = s.bus.a + 1; \
         s.bus.a = s.bus.d; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus(RW::w); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         op; \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         s.bus.a = s.pc; \
         s.bus(RW::r); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 4) \
 }
 
 #define rmw_a(opc, op) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.aux = s.bus.d; \
         s.pc = s.bus.a + 2; \
         s.bus.a += 1; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = s.aux | (s.bus.d << 8); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.bus(RW::w); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         op; \
-        break; \
-    case mc(opc, 4): \
+        return; \
+    MC(opc, 4): \
         s.bus.a = s.pc; \
         s.bus(RW::r); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 5) \
 }
 
 #define rmw_zx(opc, op) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.pc = s.bus.a + 1; \
         s.bus.a = s.bus.d; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = zp(s.bus.a + s.x); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.bus(RW::w); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         op; \
-        break; \
-    case mc(opc, 4): \
+        return; \
+    MC(opc, 4): \
         s.bus.a = s.pc; \
         s.bus(RW::r); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 5) \
 }
 
 #define rmw_ai(opc, ireg, op) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.aux = s.bus.d + ireg; \
         s.pc = s.bus.a + 2; \
         s.bus.a += 1; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = (s.aux & 0xff) | (s.bus.d << 8); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.bus.a += (s.aux & 0x100); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         s.bus(RW::w); \
-        break; \
-    case mc(opc, 4): \
+        return; \
+    MC(opc, 4): \
         op; \
-        break; \
-    case mc(opc, 5): \
+        return; \
+    MC(opc, 5): \
         s.bus.a = s.pc; \
         s.bus(RW::r); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 6) \
 }
 
 // **************** Miscellaneous Operations ****************
@@ -559,18 +577,18 @@ void MOS6502::Core::set_irq(bool act) {
     - vector address according to the latter (higher prio)
 */
 #define m_brk(opc) \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.bus(s.sp, (s.pc >> 8), RW::w); \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus(sp(s.bus.a - 1), s.pc); \
-        break; \
-    case mc(opc, 2): { \
+        return; \
+    MC(opc, 2): { \
         const auto p = s.p | Flag::u; \
         s.bus(sp(s.bus.a - 1), p); \
         s.sp = sp(s.bus.a - 1); \
-        break; } \
-    case mc(opc, 3): \
+        return; } \
+    MC(opc, 3): \
         if (s.nmi_timer & 0b11) /*Potential hijacking by nmi*/ { \
             s.brk_vec = Vec::nmi; \
             s.nmi_timer = nmi_timer_handled; \
@@ -578,267 +596,283 @@ void MOS6502::Core::set_irq(bool act) {
         s.bus.a = s.brk_vec; \
         s.brk_vec = 0; \
         s.bus(RW::r); \
-        break; \
-    case mc(opc, 4): \
+        return; \
+    MC(opc, 4): \
         s.aux = s.bus.d; \
         s.bus.a += 1; \
-        break; \
-    case mc(opc, 5): \
+        return; \
+    MC(opc, 5): \
         s.bus.a = s.aux | (s.bus.d << 8); \
         s.set(Flag::I); \
         Op{s}.schedule(OPC::dispatch_post_brk); \
-        break; \
+        return; \
+    MC_PAD(opc, 6)
 
 #define m_ja(opc) \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.aux = s.bus.d; \
         s.bus.a += 1; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = s.aux | (s.bus.d << 8); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 2)
 
 #define m_ji(opc) \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.aux = s.bus.d; \
         s.bus.a += 1; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = s.aux | (s.bus.d << 8); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.aux = s.bus.d; \
         /* the 'missing carry propagation' feature*/ \
         s.bus.a = (s.bus.a & 0xff00) | ((s.bus.a + 1) & 0xff); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         s.bus.a = s.aux | (s.bus.d << 8); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 4)
 
 #define m_js(opc) \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.aux = s.bus.d; \
         s.pc = s.bus.a + 1; \
         s.bus.a = s.sp; \
         s.sp = sp(s.sp - 2); \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.d = (s.pc >> 8); \
         s.bus(RW::w); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.bus(sp(s.bus.a - 1), u8(s.pc)); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         s.bus.a = s.pc; \
         s.bus(RW::r); \
-        break; \
-    case mc(opc, 4): \
+        return; \
+    MC(opc, 4): \
         s.bus.a = (s.aux | (s.bus.d << 8)); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 5)
 
 #define m_rts(opc) \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.bus.a = s.sp; \
         s.sp = sp(s.sp + 2); \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = sp(s.bus.a + 1); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.pc = s.bus.d; \
         s.bus.a = sp(s.bus.a + 1); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         s.bus.a = s.pc | (s.bus.d << 8); \
-        break; \
-    case mc(opc, 4): \
+        return; \
+    MC(opc, 4): \
         s.bus.a += 1; \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 5)
 
 #define m_rti(opc) \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.bus.a = s.sp; \
         s.sp = sp(s.sp + 3); \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = sp(s.bus.a + 1); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.p = s.bus.d; \
         s.bus.a = sp(s.bus.a + 1); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         s.pc = s.bus.d; \
         s.bus.a = sp(s.bus.a + 1); \
-        break; \
-    case mc(opc, 4): \
+        return; \
+    MC(opc, 4): \
         s.bus.a = s.pc | (s.bus.d << 8); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 5)
 
 #define m_brs(opc, flag) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         Op{s}.bra(Op{s}.is_set(flag)); \
-        break; \
+        return; \
+    MC_PAD(opc, 1) \
 }
 
 #define m_brc(opc, flag) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         Op{s}.bra(Op{s}.is_clr(flag)); \
-        break; \
+        return; \
+    MC_PAD(opc, 1) \
 }
 
 #define m_phr(opc, reg) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.pc = s.bus.a; \
         s.bus(s.sp, reg, RW::w); \
         s.sp = sp(s.sp - 1); \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus(s.pc, RW::r); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 2) \
 }
 
 #define m_plr(opc, op) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.pc = s.bus.a; \
         s.bus.a = s.sp; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.sp = sp(s.sp + 1); \
         s.bus.a = s.sp; \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         op; \
         s.bus.a = s.pc; \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 3) \
 }
 
 #define m_hlt(opc) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         Op{s}.halt(opc, s.bus.d); \
-        break; \
+        return; \
+    MC_PAD(opc, 1) \
 }
 
 #define m_sch(opc, nxt) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         Op{s}.schedule(nxt); \
-        break; \
+        return; \
+    MC_PAD(opc, 1) \
 }
 
 // **************** Undefined ****************
 
 #define ud_izx(opc, op) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.pc = s.bus.a + 1; \
         s.bus.a = s.bus.d; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = zp(s.bus.a + s.x); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.aux = s.bus.d; \
         s.bus.a = zp(s.bus.a + 1); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         s.bus.a = s.aux | (s.bus.d << 8); \
-        break; \
-    case mc(opc, 4): \
+        return; \
+    MC(opc, 4): \
         s.bus(RW::w); \
-        break; \
-    case mc(opc, 5): \
+        return; \
+    MC(opc, 5): \
         op; \
-        break; \
-    case mc(opc, 6): \
+        return; \
+    MC(opc, 6): \
         s.bus.a = s.pc; \
         s.bus(RW::r); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 7) \
 }
 
 #define ud_izy(opc, op) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.pc = s.bus.a + 1; \
         s.bus.a = s.bus.d; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.aux = s.bus.d + s.y; \
         s.bus.a = zp(s.bus.a + 1); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.bus.a = (s.aux & 0xff) | (s.bus.d << 8); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         s.bus.a += (s.aux & 0x100); \
-        break; \
-    case mc(opc, 4): \
+        return; \
+    MC(opc, 4): \
         s.bus(RW::w); \
-        break; \
-    case mc(opc, 5): \
+        return; \
+    MC(opc, 5): \
         op; \
-        break; \
-    case mc(opc, 6): \
+        return; \
+    MC(opc, 6): \
         s.bus.a = s.pc; \
         s.bus(RW::r); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 7) \
 }
 
 #define ud_ai(opc, ir1, ir2, op) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.aux = s.bus.d + ir1; \
         s.pc = s.bus.a + 2; \
         s.bus.a += 1; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.bus.a = (s.bus.d << 8) | (s.aux & 0xff); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.bus.d = ir2 & ((s.bus.a + 0x100) >> 8); \
         op; \
         s.bus.a = (s.aux & 0x100) \
             ? ((s.bus.d << 8) | (s.bus.a & 0xff)) \
             : s.bus.a; \
         s.bus(RW::w); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         s.bus.a = s.pc; \
         s.bus(RW::r); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 4) \
 }
 
 #define ud_ahx(opc) { \
-    case mc(opc, 0): \
+    MC(opc, 0): \
         s.pc = s.bus.a + 1; \
         s.bus.a = s.bus.d; \
-        break; \
-    case mc(opc, 1): \
+        return; \
+    MC(opc, 1): \
         s.aux = s.bus.d + s.y; \
         s.bus.a = zp(s.bus.a + 1); \
-        break; \
-    case mc(opc, 2): \
+        return; \
+    MC(opc, 2): \
         s.bus.a = (s.bus.d << 8) | (s.aux & 0xff); \
-        break; \
-    case mc(opc, 3): \
+        return; \
+    MC(opc, 3): \
         s.bus.d = s.a & s.x & ((s.bus.a + 0x100) >> 8); \
         s.bus.a = (s.aux & 0x100) \
             ? ((s.bus.d << 8) | (s.bus.a & 0xff)) \
             : s.bus.a; \
         s.bus(RW::w); \
-        break; \
-    case mc(opc, 4): \
+        return; \
+    MC(opc, 4): \
         s.bus.a = s.pc; \
         s.bus(RW::r); \
         Op{s}.schedule(OPC::dispatch); \
-        break; \
+        return; \
+    MC_PAD(opc, 5) \
 }
 
 
@@ -847,6 +881,66 @@ static constexpr MOS6502::u16 mc(MOS6502::u16 opc, MOS6502::u8 cn = 0) { // micr
 }
 
 
+/*  Micro-code dispatch, chosen at build time:
+      - default: a 'switch' on the micro-code counter
+      - 'MOS6502_DISPATCH_GOTO' (GCC/Clang only): a label table & computed goto
+    Both run the very same micro-code (i.e. cycle behaviour is identical).
+    For the label table, each opcode gets a label for all of its 8 possible steps
+    (the unused ones just return, like the missing cases of the switch).
+*/
+#if defined(MOS6502_DISPATCH_GOTO) && (defined(__GNUC__) || defined(__clang__))
+
+#define MOS6502_COMPUTED_GOTO
+
+#pragma GCC diagnostic push // (popped right after 'tick()')
+#pragma GCC diagnostic ignored "-Wpedantic" // (labels as values, computed goto)
+
+#define mc_l(opc, cn) mc_##opc##_##cn
+
+#define MC(opc, cn)     mc_l(opc, cn)
+#define MC_OPC(opc, cn) mc_l(opc, cn)
+
+#define MC_PAD(opc, from) MC_PAD_##from(opc)
+#define MC_PAD_1(opc) mc_l(opc, 1): MC_PAD_2(opc)
+#define MC_PAD_2(opc) mc_l(opc, 2): MC_PAD_3(opc)
+#define MC_PAD_3(opc) mc_l(opc, 3): MC_PAD_4(opc)
+#define MC_PAD_4(opc) mc_l(opc, 4): MC_PAD_5(opc)
+#define MC_PAD_5(opc) mc_l(opc, 5): MC_PAD_6(opc)
+#define MC_PAD_6(opc) mc_l(opc, 6): MC_PAD_7(opc)
+#define MC_PAD_7(opc) mc_l(opc, 7): return;
+
+#define MC_FALLTHROUGH
+
+#define MC_ROW(opc) \
+    &&mc_l(opc, 0), &&mc_l(opc, 1), &&mc_l(opc, 2), &&mc_l(opc, 3), \
+    &&mc_l(opc, 4), &&mc_l(opc, 5), &&mc_l(opc, 6), &&mc_l(opc, 7),
+#define MC_ROW16(h) \
+    MC_ROW(h##0) MC_ROW(h##1) MC_ROW(h##2) MC_ROW(h##3) MC_ROW(h##4) MC_ROW(h##5) MC_ROW(h##6) MC_ROW(h##7) \
+    MC_ROW(h##8) MC_ROW(h##9) MC_ROW(h##a) MC_ROW(h##b) MC_ROW(h##c) MC_ROW(h##d) MC_ROW(h##e) MC_ROW(h##f)
+
+#define MC_DISPATCH \
+    static const void* const mc_labels[] = { \
+        MC_ROW16(0x0) MC_ROW16(0x1) MC_ROW16(0x2) MC_ROW16(0x3) \
+        MC_ROW16(0x4) MC_ROW16(0x5) MC_ROW16(0x6) MC_ROW16(0x7) \
+        MC_ROW16(0x8) MC_ROW16(0x9) MC_ROW16(0xa) MC_ROW16(0xb) \
+        MC_ROW16(0xc) MC_ROW16(0xd) MC_ROW16(0xe) MC_ROW16(0xf) \
+        MC_ROW(bra) MC_ROW(dispatch_post_cli) MC_ROW(dispatch_post_sei) MC_ROW(dispatch) \
+        MC_ROW(dispatch_post_brk) MC_ROW(halt) MC_ROW(reset) \
+    }; \
+    static_assert(sizeof(mc_labels) / sizeof(mc_labels[0]) == mc(OPC::reset + 1)); \
+    goto *mc_labels[s.mcc++];
+
+#else
+
+#define MC(opc, cn)       case mc(opc, cn)
+#define MC_OPC(opc, cn)   case mc(OPC::opc, cn)
+#define MC_PAD(opc, from)
+#define MC_DISPATCH       switch (s.mcc++)
+#define MC_FALLTHROUGH    [[fallthrough]]
+
+#endif
+
+
 void MOS6502::Core::tick() {
     static constexpr u8 nmi_timer_handled = 0b10000000;
 
@@ -864,7 +958,7 @@ void MOS6502::Core::tick() {
         }
     }
 
-    switch (s.mcc++) {
+    MC_DISPATCH {
          m_brk(0x00);                            // brk
         ie_izx(0x01, Op{s}.ora());               // ora izx
          m_hlt(0x02);                            // hlt
@@ -1124,19 +1218,19 @@ void MOS6502::Core::tick() {
 
         // ********************************************************************
 
-        case mc(OPC::bra, 0): // bra, no page cross (hold ints)
+        MC_OPC(bra, 0): // bra, no page cross (hold ints)
             if (s.nmi_timer == 0x02) s.nmi_timer = 0x01;
             if (s.irq_timer & 0b11) s.irq_timer = 0b01;
             s.bus.a = s.pc;
             Op{s}.schedule(OPC::dispatch);
-            break;
-        case mc(OPC::bra, 1): // bra, page cross
+            return;
+        MC_OPC(bra, 1): // bra, page cross
             s.bus.a = s.aux;
-            break;
-        case mc(OPC::bra, 2):
+            return;
+        MC_OPC(bra, 2):
             s.bus.a = s.pc;
             Op{s}.schedule(OPC::dispatch);
-            break;
+            return;
 
         // --------------------------------------------------------------------
 
@@ -1144,15 +1238,15 @@ void MOS6502::Core::tick() {
             cli&sei feature: change not be visible at next T0 (dispatch)
             (http://visual6502.org/wiki/index.php?title=6502_Timing_of_Interrupt_Handling)
         */
-        case mc(OPC::dispatch_post_cli): 
+        MC_OPC(dispatch_post_cli, 0): 
             Op{s}.check_irq(); // irq taken on 'old' i-flag value
             s.clr(Flag::I);
             goto check_nmi;
-        case mc(OPC::dispatch_post_sei):
+        MC_OPC(dispatch_post_sei, 0):
             Op{s}.check_irq(); // irq taken on 'old' i-flag value
             s.set(Flag::I);
             goto check_nmi;
-        case mc(OPC::dispatch): // 'normal' T0 case (all interrupts taken normally)
+        MC_OPC(dispatch, 0): // 'normal' T0 case (all interrupts taken normally)
             Op{s}.check_irq();
 
             check_nmi:
@@ -1161,8 +1255,8 @@ void MOS6502::Core::tick() {
                 s.nmi_act = false;
                 if (s.nmi_timer) s.nmi_timer = nmi_timer_handled;
             }
-            // fall through
-        case mc(OPC::dispatch_post_brk):
+            MC_FALLTHROUGH;
+        MC_OPC(dispatch_post_brk, 0):
             if (!s.brk_vec) {
                 s.bus.a += 1; // 'inc pc'
                 if (s.bus.d != OPC::brk) {
@@ -1178,42 +1272,61 @@ void MOS6502::Core::tick() {
                 s.p &= ~Flag::B;
                 Op{s}.schedule(OPC::brk);
             }
-            break;
+            return;
 
         // --------------------------------------------------------------------
 
-        case mc(OPC::halt, 0):
+        MC_OPC(halt, 0):
             s.bus.a = 0xfffe;
-            break;
-        case mc(OPC::halt, 1):
-            break;
-        case mc(OPC::halt, 2):
+            return;
+        MC_OPC(halt, 1):
+            return;
+        MC_OPC(halt, 2):
             s.bus.a = 0xffff;
             sig_halt(s.aux & 0xff, s.aux >> 8);
-            break;
-        case mc(OPC::halt, 3):
+            return;
+        MC_OPC(halt, 3):
             s.mcc--; // stuck (until resume())
-            break;
+            return;
 
         // --------------------------------------------------------------------
 
-        case mc(OPC::reset, 0): s.bus.a += 1; break;
-        case mc(OPC::reset, 1): s.bus.a = 0x0100; break;
-        case mc(OPC::reset, 2): s.bus.a = 0x01ff; break;
-        case mc(OPC::reset, 3): s.bus.a = 0x01fe; break;
-        case mc(OPC::reset, 4): s.bus.a = Vec::rst; s.sp = 0x01fd; break;
-        case mc(OPC::reset, 5):
+        MC_OPC(reset, 0): s.bus.a += 1; return;
+        MC_OPC(reset, 1): s.bus.a = 0x0100; return;
+        MC_OPC(reset, 2): s.bus.a = 0x01ff; return;
+        MC_OPC(reset, 3): s.bus.a = 0x01fe; return;
+        MC_OPC(reset, 4): s.bus.a = Vec::rst; s.sp = 0x01fd; return;
+        MC_OPC(reset, 5):
             s.aux = s.bus.d;
             s.bus.a += 1;
-            break;
-        case mc(OPC::reset, 6):
+            return;
+        MC_OPC(reset, 6):
             s.bus.a = s.aux | (s.bus.d << 8);
             s.set(Flag::I);
             Op{s}.schedule(OPC::dispatch_post_brk);
-            break;
+            return;
+
+        MC_PAD(bra, 3)
+        MC_PAD(dispatch_post_cli, 1) MC_PAD(dispatch_post_sei, 1)
+        MC_PAD(dispatch, 1) MC_PAD(dispatch_post_brk, 1)
+        MC_PAD(halt, 4)
+        MC_PAD(reset, 7)
     }
 }
 
+#ifdef MOS6502_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
+
+
+const char* MOS6502::dispatch_backend() {
+#ifdef MOS6502_COMPUTED_GOTO
+    return "goto";
+#else
+    return "switch";
+#endif
+}
+
 
 void MOS6502::Core::resume() {
     if (halted()) {
@@ -113,6 +113,9 @@ private:
 
 };
 
+
+const char* dispatch_backend(); // 'switch' or 'goto' (a build option, see 'core.cpp')
+
 } // namespace MOS6502
 
 
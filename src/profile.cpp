@@ -0,0 +1,100 @@
+#ifdef PROFILE
+
+#include <algorithm>
+#include <sstream>
+#include "profile.h"
+
+
+
+using namespace Profile;
+
+
+static const char* STAGE_NAMES[Stage::_cnt + 1] = {
+    "run_cycle", "sid_sync", "output_frame", "vid_put", "input_poll", "frame_wait",
+    "frame",
+};
+
+
+u32 Histogram::avg() const {
+    if (size() == 0) return 0;
+    u64 sum = 0;
+    for (int s = 0; s < size(); ++s) sum += samples[s];
+    return sum / size();
+}
+
+
+u32 Histogram::max() const {
+    return size() ? *std::max_element(samples, samples + size()) : 0;
+}
+
+
+u32 Histogram::percentile(int p) const {
+    if (size() == 0) return 0;
+    std::vector<u32> sorted(samples, samples + size());
+    const auto nth = sorted.begin() + ((size() - 1) * p) / 100;
+    std::nth_element(sorted.begin(), nth, sorted.end());
+    return *nth;
+}
+
+
+std::vector<u16> Histogram::buckets() const {
+    std::vector<u16> b(bucket_cnt);
+    for (int s = 0; s < size(); ++s) {
+        int bucket = 0;
+        for (u32 us = samples[s] / 1000; us && bucket < (bucket_cnt - 1); us >>= 1) ++bucket;
+        ++b[bucket];
+    }
+    return b;
+}
+
+
+void Profiler::frame_done() {
+    for (int st = 0; st < Stage::_cnt; ++st) {
+        hist[st].put(frame_ns[st]);
+        frame_ns[st] = 0;
+    }
+
+    const u64 now = Clock::now_ns();
+    hist[Stage::_cnt].put(now - frame_start);
+    frame_start = now;
+
+    if ((++frame_n % dump_interval) == 0) Log::info("Profile: %s", json().c_str());
+}
+
+
+std::vector<std::string> Profiler::overlay() const {
+    std::vector<std::string> lines{"stage(us)      avg   p99   max"};
+
+    char buf[64];
+    for (int st = 0; st <= Stage::_cnt; ++st) {
+        const auto& h = hist[st];
+        snprintf(buf, sizeof(buf), "%-12s %5d %5d %5d", STAGE_NAMES[st],
+                    h.avg() / 1000, h.percentile(99) / 1000, h.max() / 1000);
+        lines.push_back(buf);
+    }
+
+    return lines;
+}
+
+
+std::string Profiler::json() const {
+    std::ostringstream o;
+
+    o << "{\"frames\": " << frame_n << ", \"window\": " << Histogram::window << ", \"stages\": {";
+    for (int st = 0; st <= Stage::_cnt; ++st) {
+        const auto& h = hist[st];
+        o << (st ? ", " : "") << "\"" << STAGE_NAMES[st] << "\": {"
+          << "\"avg_ns\": " << h.avg() << ", \"p50_ns\": " << h.percentile(50)
+          << ", \"p99_ns\": " << h.percentile(99) << ", \"max_ns\": " << h.max()
+          << ", \"hist_log2_us\": [";
+        const auto b = h.buckets();
+        for (std::size_t i = 0; i < b.size(); ++i) o << (i ? ", " : "") << b[i];
+        o << "]}";
+    }
+    o << "}}";
+
+    return o.str();
+}
+
+
+#endif // PROFILE
@@ -0,0 +1,115 @@
+#ifndef PROFILE_H_INCLUDED
+#define PROFILE_H_INCLUDED
+
+#include <string>
+#include <vector>
+#include "utils.h"
+
+#ifdef PROFILE
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#endif
+
+
+
+// Main loop instrumentation. Compiled in with 'make PROFILE=1', otherwise all
+// the probes are empty inlines (i.e. no cost).
+namespace Profile {
+
+
+enum Stage : u8 {
+    run_cycle, sid_sync, output_frame, vid_put, input_poll, frame_wait,
+    _cnt
+};
+
+
+#ifdef PROFILE
+
+class Clock {
+public:
+#ifdef _WIN32
+    static u64 now_ns() {
+        static const u64 freq = []() { LARGE_INTEGER f; QueryPerformanceFrequency(&f); return f.QuadPart; }();
+        LARGE_INTEGER c;
+        QueryPerformanceCounter(&c);
+        return (u64(c.QuadPart) / freq) * 1000000000 + ((u64(c.QuadPart) % freq) * 1000000000) / freq;
+    }
+#else
+    static u64 now_ns() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return u64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+#endif
+};
+
+
+// Per frame times (ns) over a rolling window of frames
+class Histogram {
+public:
+    static constexpr int window = 256; // frames
+    static constexpr int bucket_cnt = 16; // <1 us, <2 us, <4 us, ..., the last one: the rest
+
+    void put(u32 ns) { samples[n++ % window] = ns; }
+
+    u32 avg() const;
+    u32 max() const;
+    u32 percentile(int p) const;
+    std::vector<u16> buckets() const;
+
+private:
+    u32 samples[window] = {};
+    u32 n = 0;
+
+    int size() const { return n < window ? n : window; }
+};
+
+
+class Profiler {
+public:
+    static constexpr int dump_interval = 250; // frames
+
+    void restart() { // drops the current (partial) frame
+        frame_start = last = Clock::now_ns();
+        for (auto& ns : frame_ns) ns = 0;
+    }
+
+    // time since the previous lap goes to 'stage'
+    void lap(Stage stage) {
+        const u64 now = Clock::now_ns();
+        frame_ns[stage] += now - last;
+        last = now;
+    }
+
+    void frame_done();
+
+    std::vector<std::string> overlay() const; // one line per stage (+ frame total)
+    std::string json() const;
+
+private:
+    u64 last = 0;
+    u64 frame_start = 0;
+    u64 frame_ns[Stage::_cnt] = {};
+    u64 frame_n = 0;
+
+    Histogram hist[Stage::_cnt + 1]; // + frame total
+};
+
+#else
+
+class Profiler {
+public:
+    void restart() {}
+    void lap(Stage stage) { UNUSED(stage); }
+    void frame_done() {}
+};
+
+#endif // PROFILE
+
+
+} // namespace Profile
+
+#endif // PROFILE_H_INCLUDED
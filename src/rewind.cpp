@@ -0,0 +1,254 @@
+#include "rewind.h"
+
+#include <cstring>
+#include <algorithm>
+#include "expansion.h"
+
+
+
+using namespace Rewind;
+
+
+static constexpr std::size_t page_size = 0x100;
+
+static constexpr int keyframe_cost = 32; // unpacking one, in deltas applied (roughly)
+
+
+struct Region {
+    u8* data;
+    std::size_t size;
+
+    std::size_t page_count() const { return (size + page_size - 1) / page_size; }
+};
+
+enum Region_id : u8 { ram, core, exp_state, chips, tracks, drive, sid, _cnt };
+
+/*  A delta holds the pages as: region id, page number (u16), & the coded XOR. Or, with the
+    'absolute' bit set in the id, the page as it was. The latter is used when the in-use part
+    of the expansion/tracks changes, since the part not in use is not kept exact (e.g. not
+    stored in the keyframes).
+*/
+static constexpr u8 absolute = 0x80;
+
+
+static Region span(void* from, void* to) { return {(u8*)from, std::size_t((u8*)to - (u8*)from)}; }
+
+
+// all of the state, except 'mode' (& padding)
+static Region region(Files::System_snapshot& ss, u8 id) {
+    auto& s = ss.sys_state;
+    auto& dc = s.c1541.disk_ctrl;
+
+    switch (id) {
+        case ram:       return {s.ram, sizeof(s.ram)};
+        case core:      return span(&s.color_ram, &s.exp.state); // ... pla, exp (type, name, ...)
+        case exp_state: return {(u8*)&s.exp.state, sizeof(s.exp.state)};
+        case chips:     return span(&s.int_hub, &dc.track_data); // ... vic, cpu, cias, 1541 (most)
+        case tracks:    return {(u8*)dc.track_data, sizeof(dc.track_data)};
+        case drive:     return {(u8*)&s.c1541.system, sizeof(s.c1541.system)};
+        default:        return {(u8*)&ss.sid, sizeof(ss.sid)};
+    }
+}
+
+
+/*  Run-length coded XOR of two pages. Control byte 'c': c < 0x80 --> c + 1 zeroes
+    (i.e. bytes unchanged), otherwise (c & 0x7f) + 1 XORed bytes follow.
+*/
+static void put_xor(Bytes& to, const u8* a, const u8* b, int n) {
+    for (int i = 0; i < n;) {
+        int run = 0;
+        while (i + run < n && run < 0x80 && a[i + run] == b[i + run]) ++run;
+        if (run) {
+            to.push_back(run - 1);
+            i += run;
+            continue;
+        }
+        while (i + run < n && run < 0x80 && a[i + run] != b[i + run]) ++run;
+        to.push_back(0x80 | (run - 1));
+        for (int j = i; j < i + run; ++j) to.push_back(a[j] ^ b[j]);
+        i += run;
+    }
+}
+
+
+static const u8* apply_xor(const u8* from, u8* to, int n) { // returns the end of the coded page
+    for (int i = 0; i < n;) {
+        const u8 c = *from++;
+        const int run = (c & 0x7f) + 1;
+        if (c & 0x80) {
+            for (int j = i; j < i + run; ++j) to[j] ^= *from++;
+        }
+        i += run;
+    }
+    return from;
+}
+
+
+static void apply_delta(const Bytes& delta, Files::System_snapshot& ss) {
+    for (const u8* d = delta.data(); d < delta.data() + delta.size();) {
+        const auto r = region(ss, d[0] & ~absolute);
+        const std::size_t offs = (d[1] | (d[2] << 8)) * page_size;
+        const std::size_t n = std::min(page_size, r.size - offs);
+        if (d[0] & absolute) {
+            std::memcpy(r.data + offs, d + 3, n);
+            d += 3 + n;
+        } else {
+            d = apply_xor(d + 3, r.data + offs, n);
+        }
+    }
+}
+
+
+void Buffer::configure(std::size_t mem_limit_, int keyframe_interval_) {
+    const bool was_enabled = enabled();
+
+    mem_limit = mem_limit_;
+    keyframe_interval = keyframe_interval_;
+
+    if (!enabled()) {
+        entries.clear();
+        mem = 0;
+        shadow.reset();
+    } else if (!was_enabled) {
+        restart();
+    } else {
+        while (mem > mem_limit && !entries.empty()) {
+            mem -= entries.front().size();
+            entries.pop_front();
+        }
+    }
+}
+
+
+void Buffer::restart() {
+    if (!enabled()) return;
+
+    if (!shadow) shadow = std::make_unique<Files::System_snapshot>();
+    shadow->sys_state = snap.sys_state;
+    shadow->sid = snap.sid;
+
+    entries.clear();
+    mem = 0;
+    since_keyframe = 0;
+
+    std::fill(ram_written, ram_written + 0x100, false);
+    touch_all = false;
+}
+
+
+void Buffer::record() {
+    if (!enabled()) return;
+
+    Entry e;
+
+    auto put_page = [&](u8 id, std::size_t page, bool abs = false) {
+        const auto cur = region(snap, id);
+        const auto sh = region(*shadow, id);
+        const std::size_t offs = page * page_size;
+        const int n = std::min(page_size, cur.size - offs);
+
+        if (!abs && std::memcmp(cur.data + offs, sh.data + offs, n) == 0) return;
+
+        e.delta.push_back(abs ? (id | absolute) : id);
+        e.delta.push_back(page);
+        e.delta.push_back(page >> 8);
+        if (abs) e.delta.insert(e.delta.end(), sh.data + offs, sh.data + offs + n);
+        else put_xor(e.delta, cur.data + offs, sh.data + offs, n);
+        std::memcpy(sh.data + offs, cur.data + offs, n);
+    };
+
+    // the in-use parts (now, or in the shadow) of the expansion & the disk tracks
+    // (checked before the 'core' & 'chips' regions of the shadow get updated)
+    const auto& s = snap.sys_state;
+    const auto& ss = shadow->sys_state;
+
+    const bool exp_changed = s.exp.type != ss.exp.type;
+    const std::size_t exp_size = std::max( // (the types in use are known ones)
+            Expansion::state_size(s.exp.type).value(), Expansion::state_size(ss.exp.type).value());
+
+    using Disk_ctrl = State::C1541::Disk_ctrl;
+    const auto& len = s.c1541.disk_ctrl.track_len;
+    const auto& sh_len = ss.c1541.disk_ctrl.track_len;
+    const bool tracks_changed = !std::equal(std::begin(len), std::end(len), std::begin(sh_len));
+    u16 track_used[Disk_ctrl::track_count];
+    for (int t = 0; t < Disk_ctrl::track_count; ++t) track_used[t] = std::max(len[t], sh_len[t]);
+
+    for (std::size_t p = 0; p < 0x100; ++p) {
+        if (touch_all || ram_written[p]) put_page(ram, p);
+    }
+    std::fill(ram_written, ram_written + 0x100, false);
+    touch_all = false;
+
+    for (std::size_t p = 0; p < (exp_size + page_size - 1) / page_size; ++p) put_page(exp_state, p, exp_changed);
+
+    std::size_t next_page = 0;
+    for (int t = 0; t < Disk_ctrl::track_count; ++t) {
+        if (!track_used[t]) continue;
+        const std::size_t from = t * Disk_ctrl::max_track_len;
+        const std::size_t to = from + track_used[t];
+        for (std::size_t p = std::max(next_page, from / page_size); p * page_size < to; ++p) {
+            put_page(tracks, p, tracks_changed);
+        }
+        next_page = (to + page_size - 1) / page_size;
+    }
+
+    for (u8 id : {core, chips, drive, sid}) {
+        for (std::size_t p = 0; p < region(snap, id).page_count(); ++p) put_page(id, p);
+    }
+
+    e.delta.shrink_to_fit();
+
+    if (++since_keyframe >= keyframe_interval) {
+        since_keyframe = 0;
+        e.key = snap.pack();
+        e.key.shrink_to_fit();
+    }
+
+    mem += e.size();
+    entries.push_back(std::move(e));
+
+    while (mem > mem_limit && entries.size() > 1) {
+        mem -= entries.front().size();
+        entries.pop_front();
+    }
+}
+
+
+int Buffer::step_back(int frames) {
+    if (!enabled()) return 0;
+
+    const int m = entries.size();
+    const int n = std::min(frames, m);
+    if (n <= 0) return 0;
+
+    const int to = m - n; // entries 'to'..'m - 1' get undone (& dropped)
+
+    // the shadow is the state after entry 'm - 1', a keyframe is the state after its entry
+    // (the nearest at/after the target, if cheaper)
+    int from = m;
+    for (int k = std::max(to - 1, 0); k < m; ++k) {
+        if (entries[k].key.empty()) continue;
+        if ((k + 1 - to) + keyframe_cost < n && shadow->unpack(entries[k].key)) from = k + 1;
+        break;
+    }
+
+    for (int k = from - 1; k >= to; --k) apply_delta(entries[k].delta, *shadow);
+
+    for (u8 id = 0; id < Region_id::_cnt; ++id) {
+        const auto r = region(*shadow, id);
+        std::memcpy(region(snap, id).data, r.data, r.size);
+    }
+
+    for (int k = m - 1; k >= to; --k) {
+        mem -= entries[k].size();
+        entries.pop_back();
+    }
+
+    since_keyframe = 0;
+    for (auto e = entries.rbegin(); e != entries.rend() && e->key.empty(); ++e) ++since_keyframe;
+
+    std::fill(ram_written, ram_written + 0x100, false);
+    touch_all = false;
+
+    return n;
+}
@@ -0,0 +1,72 @@
+#ifndef REWIND_H_INCLUDED
+#define REWIND_H_INCLUDED
+
+#include <deque>
+#include <memory>
+#include "common.h"
+#include "files.h"
+
+
+
+namespace Rewind {
+
+
+/*  History of the system state, one entry per frame (recorded at the frame end).
+    An entry holds the delta to the previous frame: the XOR (run-length coded) of the
+    256 byte pages changed. The latest recorded state is kept as a whole (the 'shadow'),
+    stepping back applies the deltas to it (in reverse), & then copies it over.
+    Every 'keyframe_interval'th entry also holds the (packed) state itself, so that a
+    longer step back can start from the nearest one instead.
+    The C64 RAM pages are compared only if written (tracked by the bus), the rest of the
+    state is compared in whole (only the in-use parts of the expansion & disk tracks).
+    The oldest entries get dropped to stay within the memory limit (excluding the shadow,
+    and a scratch buffer, i.e. ~2x the size of the state).
+*/
+class Buffer {
+public:
+    Buffer(Files::System_snapshot& snap_, bool* ram_written_) : snap(snap_), ram_written(ram_written_) {}
+
+    void configure(std::size_t mem_limit_, int keyframe_interval_); // mem_limit 0 --> off
+    bool enabled() const { return mem_limit > 0; }
+
+    void restart(); // the current state as the starting point (history dropped)
+
+    void ram_touched() { touch_all = true; } // RAM changed by other means than the bus
+
+    void record(); // 'snap' (incl. the SID state) as the state of the frame just done
+
+    // to the state 'frames' before the last recorded one (i.e. the current frame, not
+    // yet recorded, is dropped too), returns the count of frames stepped back
+    int step_back(int frames);
+
+    int frames() const { return entries.size(); }
+    std::size_t mem_used() const { return mem; }
+
+private:
+    struct Entry {
+        Bytes delta;
+        Bytes key;
+
+        std::size_t size() const { return sizeof(Entry) + delta.capacity() + key.capacity(); }
+    };
+
+    Files::System_snapshot& snap;
+    bool* ram_written; // [0x100]
+
+    std::unique_ptr<Files::System_snapshot> shadow;
+
+    std::deque<Entry> entries;
+    std::size_t mem = 0;
+
+    std::size_t mem_limit = 0;
+    int keyframe_interval = 50;
+    int since_keyframe = 0;
+
+    bool touch_all = true;
+};
+
+
+} // namespace Rewind
+
+
+#endif // REWIND_H_INCLUDED
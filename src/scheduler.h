@@ -0,0 +1,75 @@
+#ifndef SCHEDULER_H_INCLUDED
+#define SCHEDULER_H_INCLUDED
+
+#include "common.h"
+
+
+
+// Cycle based event scheduling (keyed on the system cycle)
+namespace Sched {
+
+
+/*  Each source has (at most) one pending event, i.e. the next cycle it needs to
+    be run at. Sources (re)register themselves, typically when run (or when their
+    state gets changed from the outside, e.g. by a register write).
+    A source may get run early (e.g. after 'reset()'), so each has to check for
+    itself if it really is due.
+*/
+class Scheduler {
+public:
+    using Id = u8;
+
+    static constexpr int max_sources = 8;
+    static constexpr u64 never = ~u64(0);
+
+    Scheduler() { reset(); }
+
+    void at(Id id, u64 cycle) {
+        due[id] = cycle;
+        if (cycle < next) next = cycle;
+    }
+
+    // all sources due (they re-register when run), e.g. after a state restore
+    void reset() {
+        for (auto& d : due) d = 0;
+        next = 0;
+    }
+
+    bool pending(const u64& cycle) const { return cycle >= next; }
+    u64 next_due() const { return next; }
+
+    // runs the due sources (in 'Id' order)
+    template<typename Handler>
+    void run(const u64& cycle, Handler&& handler) {
+        for (Id id = 0; id < max_sources; ++id) {
+            if (due[id] <= cycle) {
+                due[id] = never;
+                handler(id);
+            }
+        }
+        next = never;
+        for (const auto d : due) if (d < next) next = d;
+    }
+
+private:
+    u64 next;
+    u64 due[max_sources];
+};
+
+
+// a source's handle to its event
+class Event {
+public:
+    Event(Scheduler& sched_, Scheduler::Id id_) : sched(sched_), id(id_) {}
+
+    void at(u64 cycle) { sched.at(id, cycle); }
+
+private:
+    Scheduler& sched;
+    const Scheduler::Id id;
+};
+
+
+} // namespace Sched
+
+#endif // SCHEDULER_H_INCLUDED
@@ -1,21 +1,89 @@
 
+#include <algorithm>
 #include "sid.h"
 
 
 void reSID_Wrapper::reconfig(double frame_rate, bool sync_clock_to_frame_rate) {
+    drain();
     if (sync_clock_to_frame_rate) {
         core.set_clock_freq(frame_rate * FRAME_CYCLE_COUNT);
-        clock_speed_base = 1.0;
+        clock_speed = 1.0;
     } else {
         core.set_clock_freq(CPU_FREQ_PAL);
-        clock_speed_base = FRAME_RATE_PAL / frame_rate;
+        clock_speed = FRAME_RATE_PAL / frame_rate;
     }
 }
 
 
-void reSID_Wrapper::tick() {
-    int cycles = clock_speed * (system_cycle - last_tick_cycle);
-    last_tick_cycle = system_cycle;
+void reSID_Wrapper::threaded(bool on) {
+    if (on == threaded_on) return;
+
+    if (on) {
+        worker_quit = false;
+        worker = std::thread([this]() { work(); });
+    } else {
+        drain();
+        {
+            std::lock_guard<std::mutex> lock(worker_mutex);
+            worker_quit = true;
+        }
+        worker_wake.notify_one();
+        worker.join();
+    }
+
+    threaded_on = on;
+
+    Log::info("SID: %s", on ? "threaded" : "in-line");
+}
+
+
+void reSID_Wrapper::drain() {
+    if (!threaded_on || cmds_done.load(std::memory_order_acquire) == cmds_pushed) return;
+
+    wake_worker();
+
+    std::unique_lock<std::mutex> lock(worker_mutex);
+    worker_idle.wait(lock, [&]() { return cmds_done.load(std::memory_order_acquire) == cmds_pushed; });
+}
+
+
+void reSID_Wrapper::work() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(worker_mutex);
+            worker_wake.wait(lock, [&]() { return worker_quit || !cmds->empty(); });
+            if (cmds->empty()) return; // quit
+        }
+
+        u64 done = cmds_done.load(std::memory_order_relaxed);
+        while (!cmds->empty()) {
+            const Cmd& cmd = cmds->front();
+            tick(cmd.cycle);
+            switch (cmd.op) {
+                case Cmd::write:
+                    core.write(cmd.ri, cmd.data);
+                    break;
+                case Cmd::sync_output:
+                    output();
+                    [[fallthrough]];
+                case Cmd::sync:
+                    buf_ptr = buf;
+                    break;
+            }
+            cmds->pop();
+            ++done;
+        }
+        cmds_done.store(done, std::memory_order_release);
+
+        { std::lock_guard<std::mutex> lock(worker_mutex); }
+        worker_idle.notify_one();
+    }
+}
+
+
+void reSID_Wrapper::tick(u64 to_cycle) {
+    int cycles = clock_speed * (to_cycle - last_tick_cycle);
+    last_tick_cycle = to_cycle;
 
     if (cycles > 0) {
         // there is always enough space in the buffer (hence the '0xffff')
@@ -25,18 +93,24 @@ void reSID_Wrapper::tick() {
 
 
 void reSID_Wrapper::output() {
-    const int buffered = audio_out.put(buf, buf_ptr - buf);
+    const int samples_out = buf_ptr - buf;
+    const int buffered = audio_out.put(buf, samples_out);
 
-    const int buffered_lo = audio_out_buf_sz * 2;
-    const int buffered_hi = 3 * buffered_lo;
+    const int buffered_target = audio_out_buf_sz * 4;
+    core.set_sampling_ratio(rate_control.ratio(buffered, buffered_target, samples_out));
+}
 
-    // Some crude clock speed control here. Good'nuff..? (Not tested on low-end machines...)
-    if (buffered < buffered_lo) {
-        clock_speed = 1.01 * clock_speed_base;
-    } else if (buffered > buffered_hi) {
-        const float reduction = 0.01 + (((buffered - buffered_hi) / audio_out_buf_sz) / 100.0);
-        clock_speed = (1 - reduction) * clock_speed_base;
-    } else {
-        clock_speed = clock_speed_base;
-    }
-}
\ No newline at end of file
+
+double reSID_Wrapper::Rate_control::ratio(int level_now, int level_target, int samples_out) {
+    const double dt = double(samples_out) / AUDIO_OUTPUT_FREQ;
+
+    // the level jumps with each device buffer pull --> low-pass it
+    if (level < 0) level = level_now;
+    else level += (level_now - level) * std::min(1.0, dt / lp_time);
+
+    const double error = (level_target - level) / AUDIO_OUTPUT_FREQ; // seconds
+    const double integral_max = max_adj / ki; // (anti-windup)
+    integral = std::clamp(integral + error * dt, -integral_max, integral_max);
+
+    return 1.0 + std::clamp(kp * error + ki * integral, -max_adj, max_adj);
+}
@@ -1,9 +1,14 @@
 #ifndef SID_H_INCLUDED
 #define SID_H_INCLUDED
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include "resid/sid.h"
 #include "host.h"
 #include "menu.h"
+#include "utils.h"
 
 
 
@@ -11,49 +16,89 @@
 class reSID_Wrapper {
 public:
     reSID_Wrapper(int min_frame_rate, int min_sync_points, const u64& system_cycle_) : system_cycle(system_cycle_) {
-        // max. ever needed (with some extra for the crude clock speed control)
+        // max. ever needed (with some extra for the rate control)
         const int max_buf_sz = (1.01 * ((AUDIO_OUTPUT_FREQ / min_frame_rate) / min_sync_points)) + 8;
         buf = buf_ptr = new i16[max_buf_sz];
     }
+    ~reSID_Wrapper() { threaded(false); }
 
     class Core : public reSID::SID {
     public:
         bool set_clock_freq(double clock_freq) {
-            return set_sampling_parameters(clock_freq, sampling, AUDIO_OUTPUT_FREQ);
+            return set_sampling_parameters(clock_freq, sampling, sample_freq());
         }
         bool set_sampling_method(reSID::sampling_method method) {
-            return set_sampling_parameters(clock_frequency, method, AUDIO_OUTPUT_FREQ);
+            return set_sampling_parameters(clock_frequency, method, sample_freq());
         }
+        void set_sampling_ratio(double ratio) { // (on the fly)
+            if (ratio == sampling_ratio) return;
+            sampling_ratio = ratio;
+            adjust_sampling_frequency(sample_freq());
+        }
+
+    private:
+        double sampling_ratio = 1.0;
+
+        double sample_freq() const { return AUDIO_OUTPUT_FREQ * sampling_ratio; }
     };
 
     Core core;
 
-    void reset() { core.reset(); }
+    void reset() { drain(); core.reset(); }
     void flush() {
+        drain();
         audio_out.flush();
         buf_ptr = buf;
         last_tick_cycle = system_cycle;
+        rate_control.reset();
     }
 
     void reconfig(double frame_rate, bool sync_clock_to_frame_rate);
 
-    void reconfig(u16 audio_out_buf_sz_) { audio_out_buf_sz = audio_out.config(audio_out_buf_sz_); }
+    void reconfig(u16 audio_out_buf_sz_) {
+        drain();
+        audio_out_buf_sz = audio_out.config(audio_out_buf_sz_);
+    }
 
     void sync(bool do_output = true) {
-        tick();
+        if (threaded_on) {
+            push({system_cycle, do_output ? Cmd::sync_output : Cmd::sync, 0, 0});
+            wake_worker();
+            return;
+        }
+        tick(system_cycle);
         if (do_output) output();
         buf_ptr = buf;
     }
 
     // TODO: tick also on read of one/some of the regs (rnd generator(s)...)
-    void r(const u8& ri, u8& data) { data = core.read(ri); }
+    void r(const u8& ri, u8& data) {
+        drain(); // (reads see all the writes so far, as when not threaded)
+        data = core.read(ri);
+    }
     void w(const u8& ri, const u8& data) {
-        tick(); // tick with old state first
+        if (threaded_on) {
+            push({system_cycle, Cmd::write, ri, data});
+            return;
+        }
+        tick(system_cycle); // tick with old state first
         core.write(ri, data);
     }
 
+    reSID::SID::State read_state() { drain(); return core.read_state(); }
+    void write_state(const reSID::SID::State& state) { drain(); core.write_state(state); }
+
+    /*  Threaded: the core is clocked (& the output produced) by a worker thread, fed with
+        timestamped register writes & sync points (woken up at the sync points only).
+        Everything else touching the core (reads, state, settings...) first waits for the
+        worker to catch up ('drain()'), i.e. the output is identical to the non-threaded.
+    */
+    void threaded(bool on);
+
     Menu::Group settings_menu() { return {"Audio", menu_items}; }
 
+    Host::Audio_out& audio_output() { return audio_out; }
+
 private:
     // TODO: consider moving stuph to 'state' (at least 'last_tick_cycle', since now a
     //       'pre_run()' (which does a 'sid.flush()') call is required when state is loaded
@@ -64,11 +109,29 @@ private:
     u64 last_tick_cycle = 0;
     const u64& system_cycle;
 
-    float clock_speed_base = 1.0;
     float clock_speed = 1.0;
 
     u16 audio_out_buf_sz;
 
+    /*  PI control of the audio output level. Adjusts the sampling frequency (i.e. the
+        resampling ratio) by tiny fractions (max. 0.5%, i.e. < 9 cents), so that the level
+        settles at the target, without audible pitch wobble.
+    */
+    struct Rate_control {
+        static constexpr double kp = 0.5;       // per second of level error
+        static constexpr double ki = 0.05;      // per second^2 of level error
+        static constexpr double max_adj = 0.005;
+        static constexpr double lp_time = 0.1;  // level low-pass, seconds
+
+        double level = -1; // low-passed (-1 --> none yet)
+        double integral = 0;
+
+        void reset() { level = -1; integral = 0; }
+
+        double ratio(int level_now, int level_target, int samples_out);
+    };
+    Rate_control rate_control;
+
     Host::Audio_out audio_out;
 
     struct Settings {
@@ -86,11 +149,48 @@ private:
     Settings set;
 
     std::vector<Menu::Knob> menu_items{
-        {"reSID model",    set.model,    [&](){ core.set_chip_model(set.model); }},
-        {"reSID sampling", set.sampling, [&](){ core.set_sampling_method(set.sampling); }},
+        {"reSID model",    set.model,    [&](){ drain(); core.set_chip_model(set.model); }},
+        {"reSID sampling", set.sampling, [&](){ drain(); core.set_sampling_method(set.sampling); }},
+    };
+
+    struct Cmd {
+        enum Op : u8 { write, sync, sync_output };
+
+        u64 cycle;
+        Op op;
+        u8 ri;
+        u8 data;
     };
+    using Cmd_queue = SPSC_ring<Cmd, 0x1000>;
+
+    bool threaded_on = false;
+    std::unique_ptr<Cmd_queue> cmds{std::make_unique<Cmd_queue>()};
+    u64 cmds_pushed = 0;
+    std::atomic<u64> cmds_done{0};
+
+    std::thread worker;
+    std::mutex worker_mutex;
+    std::condition_variable worker_wake;
+    std::condition_variable worker_idle;
+    bool worker_quit = false;
+
+    void push(const Cmd& cmd) {
+        while (cmds->full()) {
+            wake_worker();
+            std::this_thread::yield();
+        }
+        cmds->back() = cmd;
+        cmds->push();
+        ++cmds_pushed;
+    }
+    void wake_worker() {
+        { std::lock_guard<std::mutex> lock(worker_mutex); }
+        worker_wake.notify_one();
+    }
+    void drain();
+    void work(); // (worker thread)
 
-    void tick();
+    void tick(u64 to_cycle);
     void output();
 };
 
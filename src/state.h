@@ -177,6 +177,10 @@ struct CIA {
     TOD tod;
 
     bool cnt;
+
+    // idling (i.e. timers counting down/stopped, nothing else going on)
+    u64 synced_cycle; // last cycle ticked for real (or synced up to)
+    u64 idle_until;   // next cycle that needs a real tick
 };
 
 
@@ -265,7 +269,7 @@ struct C1541 {
 
 struct System {
     enum class Mode {
-        none, clocked, stepped, unlimited
+        none, clocked, stepped, unlimited, headless
     };
 
     struct ROM {
@@ -358,7 +362,6 @@ struct System {
             u8 bank;
         };
 
-        // TODO: compact state files (store only what is in use...)
         union State {
             REU reu;
             Generic generic;
@@ -1,6 +1,7 @@
 
 #include "system.h"
 #include <fstream>
+#include <filesystem>
 
 
 
@@ -273,7 +274,12 @@ void System::Menu::handle_key(u8 code) {
 void System::C64::run(Mode init_mode) {
     s.mode = init_mode;
 
+    rewind_config();
+
     reset_cold();
+    rewind_restart(); // (configured before the reset, possibly)
+
+    if (!input_rec_on_run.empty()) input_rec_start(input_rec_on_run);
 
     do {
         switch (s.mode) {
@@ -281,14 +287,23 @@ void System::C64::run(Mode init_mode) {
             case Mode::clocked:   run_clocked();   break;
             case Mode::stepped:   run_stepped();   break;
             case Mode::unlimited: run_unlimited(); break;
+            case Mode::headless:  run_headless();  break;
         }
         pre_run();
     }
     while (s.mode != Mode::none);
+
+    input_rec_stop();
 }
 
 
+// NOTE: the loads from the input wait for the frame end, so that a replay applies them
+//       at the same cycle in every mode
 void System::C64::check_deferred() {
+    if (deferred_input && (s.vic.cycle % FRAME_CYCLE_COUNT) == 0) {
+        deferred_input();
+        deferred_input = nullptr;
+    }
     if (deferred) {
         deferred();
         deferred = nullptr;
@@ -431,75 +446,96 @@ void System::C64::log_status() {
 
 
 void System::C64::pre_run() {
+    sched.reset(); // the event sources re-register (e.g. after a state restore)
+    rewind.ram_touched(); // (a reset, a state restore, ...)
+    vic.changed.all(); // (the frame too)
+    if (!replaying) for (auto& ev : input_queue) ev.cycle = s.vic.cycle + 1; // (the cycle may have changed)
+
+    vic.line_batching(perf.vic_line_batching && s.mode != Mode::stepped);
+    vic.pixel_output(s.mode != Mode::headless || headless_pixels);
+    sid.threaded(sid_threaded());
+
     switch (s.mode) {
         case Mode::none: break;
         case Mode::clocked:
             vid_out.flip();
             sid.flush();
             frame_timer.reset();
-            watch.start();
+            prof.restart();
             break;
         case Mode::stepped:
             sid.flush();
             log_status();
             break;
         case Mode::unlimited:
+        case Mode::headless:
             sid.flush();
+            prof.restart();
             break;
     }
 }
 
 
+template<u8 cfg>
 void System::C64::run_clocked() {
     auto sync = [&]() {
         const auto frame_duration = [&]() { return Timer::one_second() / perf.frame_rate.chosen; };
 
+        prof.lap(Profile::run_cycle);
+
         const bool frame_done = (s.vic.cycle % FRAME_CYCLE_COUNT) == 0;
         if (frame_done) {
-            watch.stop();
-            
             if (vid_out.v_synced()) {
                 output_frame();
                 frame_timer.reset();
             } else {
                 frame_timer.wait_elapsed(frame_duration(), true);
+                prof.lap(Profile::frame_wait);
                 output_frame();
             }
-            
-            watch.start();
-            
+
             sid.sync();
+            prof.lap(Profile::sid_sync);
 
             host_input.poll();
-            
-            watch.stop();
-            watch.reset();
+            prof.lap(Profile::input_poll);
 
+            rewind_frame();
             check_deferred();
+
+            prof.frame_done();
         } else {
-            watch.stop();
-            
             const auto frame_progress = double(s.vic.raster_y) / double(FRAME_LINE_COUNT);
             const auto frame_progress_time = frame_progress * frame_duration();
             frame_timer.wait_elapsed(frame_progress_time);
-            
-            watch.start();
-            
+            prof.lap(Profile::frame_wait);
+
             sid.sync();
+            prof.lap(Profile::sid_sync);
 
             host_input.poll();
+            prof.lap(Profile::input_poll);
         }
     };
 
-    // TODO: consider special loops for different configs (e.g. REU with no 1541)
     while (s.mode == Mode::clocked) {
-        run_cycle();
+        run_cycle<cfg>();
         const bool sync_point = (s.vic.cycle % perf.latency.chosen.sync_freq) == 0;
-        if (sync_point) sync();
+        if (sync_point) {
+            sync();
+            if (run_cfg() != cfg) return;
+        }
     }
 }
 
 
+void System::C64::run_clocked() {
+    do {
+        dispatch_run_cfg([this](auto cfg) { run_clocked<decltype(cfg)::value>(); });
+    } while (s.mode == Mode::clocked);
+}
+
+
 void System::C64::run_stepped() {
     frame_timer.reset();
 
@@ -512,25 +548,85 @@ void System::C64::run_stepped() {
 }
 
 
+template<u8 cfg>
 void System::C64::run_unlimited() {
     auto frame_done = [&]() {
-        const bool the_50th_frame = ((s.vic.cycle / FRAME_CYCLE_COUNT) % 50) == 0;
-        if (the_50th_frame) {
+        prof.lap(Profile::run_cycle);
+
+        const auto the_50th_frame = [&](u64 frame) { return (frame % 50) == 0; };
+        const u64 frame = s.vic.cycle / FRAME_CYCLE_COUNT;
+        if (the_50th_frame(frame)) {
             output_frame();
             host_input.poll();
-            check_deferred();
+            prof.lap(Profile::input_poll);
         }
+        if (perf.warp_frame_skip) vic.pixel_output(the_50th_frame(frame + 1));
         sid.sync(false);
+        prof.lap(Profile::sid_sync);
+
+        rewind_frame();
+        check_deferred();
+
+        prof.frame_done();
     };
 
     while (s.mode == Mode::unlimited) {
-        run_cycle();
+        if (!(perf.cpu_run_ahead && run_ahead<cfg>())) run_cycle<cfg>();
         const bool frame_is_done = (s.vic.cycle % FRAME_CYCLE_COUNT) == 0;
-        if (frame_is_done) frame_done();
+        if (frame_is_done) {
+            frame_done();
+            if (run_cfg() != cfg) return;
+        }
     }
 }
 
 
+void System::C64::run_unlimited() {
+    do {
+        dispatch_run_cfg([this](auto cfg) { run_unlimited<decltype(cfg)::value>(); });
+    } while (s.mode == Mode::unlimited);
+}
+
+
+// no frame output, no pacing (input from the host, i.e. a script if headless)
+template<u8 cfg>
+void System::C64::run_headless() {
+    auto frame_done = [&]() {
+        prof.lap(Profile::run_cycle);
+#ifdef HEADLESS
+        sid.sync(); // --> null sink (capturing, if requested)
+        prof.lap(Profile::sid_sync);
+        if (frame_hook && !frame_hook(s)) request_shutdown(); // (counted as input)
+#else
+        sid.sync(false);
+        prof.lap(Profile::sid_sync);
+#endif
+        host_input.poll();
+        prof.lap(Profile::input_poll);
+        rewind_frame();
+        check_deferred();
+
+        prof.frame_done();
+    };
+
+    while (s.mode == Mode::headless) {
+        if (!(perf.cpu_run_ahead && run_ahead<cfg>())) run_cycle<cfg>();
+        const bool frame_is_done = (s.vic.cycle % FRAME_CYCLE_COUNT) == 0;
+        if (frame_is_done) {
+            frame_done();
+            if (run_cfg() != cfg) return;
+        }
+    }
+}
+
+
+void System::C64::run_headless() {
+    do {
+        dispatch_run_cfg([this](auto cfg) { run_headless<decltype(cfg)::value>(); });
+    } while (s.mode == Mode::headless);
+}
+
+
 // TODO: when stepping cycle/instr/line, add a beam_pos indicator (line/dot?)
 void System::C64::step_forward(u8 key_code) {
     using kc = Key_code::System;
@@ -538,21 +634,27 @@ void System::C64::step_forward(u8 key_code) {
     // 'clear' remaining pixels (yes, most of the time this is redundant, but meh... )
     for (auto bp = s.vic.beam_pos; bp < VIC_II::FRAME_SIZE; ++bp)
         s.vic.frame[bp] = Color::black;
+    if (s.vic.beam_pos < VIC_II::FRAME_SIZE) vic.changed.at(s.vic.beam_pos, VIC_II::FRAME_SIZE);
+
+    auto step = [&]() {
+        run_cycle();
+        if (deferred_input) check_deferred(); // (at a frame end, as when running)
+    };
 
     switch (key_code) {
         case kc::step_cycle:
-            run_cycle();
+            step();
             break;
         case kc::step_instr:
             if (!cpu.halted()) {
-                do run_cycle(); while (!cpu.at_fetch());
+                do step(); while (!cpu.at_fetch());
             }
             break;
         case kc::step_line:
-            do run_cycle(); while (s.vic.line_cycle() < (LINE_CYCLE_COUNT - 1));
+            do step(); while (s.vic.line_cycle() < (LINE_CYCLE_COUNT - 1));
             break;
         case kc::step_frame:
-            do run_cycle(); while (s.vic.frame_cycle() < (FRAME_CYCLE_COUNT - 1));
+            do step(); while (s.vic.frame_cycle() < (FRAME_CYCLE_COUNT - 1));
             break;
     }
 
@@ -563,6 +665,7 @@ void System::C64::step_forward(u8 key_code) {
 struct PETSCII_Draw { // user is trusted, no checks...
     const u8* charrom;
     u8* tgt;
+    VIC_II::Changed_lines& changed;
     const u16 tgt_w = VIC_II::FRAME_WIDTH;
 
     //void clear(u8 col) { for (int p = 0; p < tgt_w * tgt_h; ++p) tgt[p] = col; }
@@ -573,6 +676,7 @@ struct PETSCII_Draw { // user is trusted, no checks...
             u8* t = &tgt[(px_row + cy) * tgt_w + cx];
             for (u8 px = 0b10000000; px; px >>= 1) *t++ = (*src & px) ? fg : bg;
         }
+        changed.at(cy * tgt_w, (cy + 8) * tgt_w);
     }
 
     void txt(const std::string& txt, u16 tx, u16 ty, Color fg, Color bg) {
@@ -593,7 +697,7 @@ void System::C64::output_frame() {
         static const Color col_fg = Color::light_green;
         static const Color col_bg = Color::gray_1;
 
-        PETSCII_Draw pd{rom.charr, s.vic.frame};
+        PETSCII_Draw pd{rom.charr, s.vic.frame, vic.changed};
 
         pd.txt(std::string(width_chr, ' '), pos_x, pos_y, col_fg, col_bg);
         pd.txt(menu.text(), pos_x + pad_px, pos_y, col_fg, col_bg);
@@ -627,7 +731,7 @@ void System::C64::output_frame() {
             const auto led_ch = c1541.dc.status.write_prot_on() ? ch_led_wp : ch_led;
             const auto led_col = c1541.dc.status.led_on() ? col_led_on : col_led_off;
 
-            PETSCII_Draw{rom.charr, s.vic.frame}.chr(led_ch, pos_x, pos_y, led_col, col_bg);
+            PETSCII_Draw{rom.charr, s.vic.frame, vic.changed}.chr(led_ch, pos_x, pos_y, led_col, col_bg);
 
             /*static constexpr u16 ch_zero   = 0x0030;
             const auto track_n = (status.head.track_n / 2) + 1;
@@ -644,7 +748,7 @@ void System::C64::output_frame() {
             static const Color col_fg = Color::light_green;
             static const Color col_bg = Color::gray_1;
 
-            PETSCII_Draw pd{rom.charr, s.vic.frame};
+            PETSCII_Draw pd{rom.charr, s.vic.frame, vic.changed};
 
             if (!c1541.disk_carousel.no_disk()) {
                 static const int pos_y = 14;
@@ -661,19 +765,70 @@ void System::C64::output_frame() {
             }
         };
 
+        auto draw_state_saver = [&]() {
+            static const int pos_y = (VIC_II::FRAME_HEIGHT - VIC_II::BORDER_SZ_H) + 14;
+            static const int pos_x = VIC_II::BORDER_SZ_V + 4;
+            static const int show_frames = 100; // after done
+
+            static const Color col_fg = Color::light_green;
+            static const Color col_fg_fail = Color::light_red;
+            static const Color col_bg = Color::gray_1;
+
+            using Status = Files::Snapshot_saver::Status;
+
+            const auto status = state_saver.status();
+            if (status == Status::saving) state_saver_msg_timer = show_frames;
+            if (state_saver_msg_timer == 0) return;
+            --state_saver_msg_timer;
+
+            const char* txt = status == Status::saving ? " saving state... "
+                : status == Status::saved ? " state saved " : " save state failed ";
+            const Color col = status == Status::failed ? col_fg_fail : col_fg;
+
+            PETSCII_Draw{rom.charr, s.vic.frame, vic.changed}.txt(txt, pos_x, pos_y, col, col_bg);
+        };
+
         if (show_status) {
             draw_c1541_led();
             draw_disk_and_exp_names();
         } else if (c1541.dc.status.head.active()) {
             draw_c1541_led();
         }
+
+        draw_state_saver();
+    };
+
+#ifdef PROFILE
+    auto draw_profile = [&]() {
+        static const int pos_x = VIC_II::BORDER_SZ_V + 4;
+        static const int pos_y = VIC_II::BORDER_SZ_H + 4;
+        static const Color col_fg = Color::light_green;
+        static const Color col_bg = Color::gray_1;
+
+        PETSCII_Draw pd{rom.charr, s.vic.frame, vic.changed};
+
+        int y = pos_y;
+        for (const auto& line : prof.overlay()) {
+            pd.txt(line, pos_x, y, col_fg, col_bg);
+            y += 10;
+        }
     };
+#endif
 
     if (menu.active) draw_menu();
 
     draw_status();
 
-    vid_out.put(s.vic.frame);
+#ifdef PROFILE
+    if (perf.profile_overlay) draw_profile();
+#endif
+
+    prof.lap(Profile::output_frame);
+
+    vid_out.put(s.vic.frame, vic.changed.line);
+    vic.changed.none();
+
+    prof.lap(Profile::vid_put);
 }
 
 
@@ -716,26 +871,188 @@ void System::C64::reset_cold() {
 void System::C64::save_state_req() {
     static const std::string dir = "./_local"; // TODO...
 
-    // TODO: spawn thread (a copy of sys_snap required though...)?
+    // only the copying of the state is done here, the rest happens in the background
     deferred = [&]() {
-        sys_snap.sid = sid.core.read_state();
+        sys_snap.sid = sid.read_state();
 
         const std::string filepath = as_lower(dir + "/emu.state"); // TODO...
-        // TODO: hadle exceptions?
-        if (auto f = std::ofstream(filepath, std::ios::binary)) {
-            f.write((const char*)&sys_snap, sizeof(sys_snap));
-            if (f) Log::info("State saved: %s", filepath.c_str());
-            else Log::error("save state failed");
-        }
+        if (!state_saver.save(sys_snap, filepath)) Log::error("save state: previous save still in progress");
     };
 };
 
 
-bool System::C64::handle_file(Files::File& file) {
-    auto inject = [&](const Bytes& data) {
+void System::C64::rewind_frame() {
+    if (!rewind.enabled()) return;
+
+    if (rewinding) {
+        rewind_step();
+    } else {
+        sys_snap.sid = sid.read_state();
+        rewind.record();
+    }
+}
+
+
+void System::C64::rewind_step() {
+    const auto held = s.input_matrix; // the host input is not rewound...
+
+    if (!rewind.step_back(1)) return;
+
+    state_rewound();
+
+    // ... but fed in again (ahead of any queued), so that no key/direction gets stuck
+    const auto& was = s.input_matrix;
+    std::vector<In_ev> evs;
+    for (u8 code = 0; code < 64; ++code) {
+        const u64 key = u64{0b1} << (63 - code);
+        if ((held.key_states ^ was.key_states) & key) {
+            evs.push_back({0, In_ev::keyboard, code, u8((held.key_states & key) != 0), ""});
+        }
+    }
+    for (u8 bit = 0; bit < 8; ++bit) {
+        const u8 b = 0b1 << bit;
+        if ((held.cp1_state ^ was.cp1_state) & b) evs.push_back({0, In_ev::ctrl_port_1, bit, u8(!(held.cp1_state & b)), ""});
+        if ((held.cp2_state ^ was.cp2_state) & b) evs.push_back({0, In_ev::ctrl_port_2, bit, u8(!(held.cp2_state & b)), ""});
+    }
+    if (evs.empty()) return;
+
+    for (auto ev = evs.rbegin(); ev != evs.rend(); ++ev) {
+        ev->cycle = s.vic.cycle + 1;
+        input_queue.push_front(std::move(*ev));
+    }
+    sched.at(Event::input_ev, input_queue.front().cycle);
+}
+
+
+void System::C64::state_rewound() {
+    sched.reset();
+    vic.changed.all();
+    sid.write_state(sys_snap.sid);
+    sid.flush();
+
+    // the recording continues from here, a replay can not
+    if (input_rec) {
+        auto& evs = input_rec->events;
+        while (!evs.empty() && evs.back().cycle > s.vic.cycle) evs.pop_back();
+    }
+    input_replay_stop();
+    for (auto& ev : input_queue) ev.cycle = s.vic.cycle + 1;
+}
+
+
+void System::C64::queue_input(In_ev ev) {
+    if (replaying) return;
+
+    ev.cycle = s.vic.cycle + 1;
+    input_queue.push_back(std::move(ev));
+    sched.at(Event::input_ev, input_queue.front().cycle);
+}
+
+
+void System::C64::run_input() {
+    while (!input_queue.empty() && input_queue.front().cycle <= s.vic.cycle) {
+        const In_ev ev = std::move(input_queue.front());
+        input_queue.pop_front();
+
+        if (input_rec) input_rec->events.push_back(ev);
+
+        switch (ev.target) {
+            case In_ev::keyboard:    input_matrix.keyboard(ev.code, ev.down);    break;
+            case In_ev::ctrl_port_1: input_matrix.ctrl_port_1(ev.code, ev.down); break;
+            case In_ev::ctrl_port_2: input_matrix.ctrl_port_2(ev.code, ev.down); break;
+            case In_ev::restore:
+                if (!ev.down) int_hub.int_sig.set(IO::Int_sig::Src::rstr);
+                break;
+            case In_ev::drop: {
+                const auto name = std::filesystem::path(ev.path).filename().string();
+                if (auto file = Files::identify(name, ev.data); file.identified()) handle_file(file, true);
+                else Log::error("Input: unable to identify '%s'", ev.path.c_str());
+                break;
+            }
+        }
+    }
+
+    if (replaying && input_queue.empty()) {
+        replaying = false;
+        Log::info("Input replay: done");
+    }
+
+    sched.at(Event::input_ev, input_queue.empty() ? Sched::Scheduler::never : input_queue.front().cycle);
+}
+
+
+void System::C64::input_rec_req() {
+    static const std::string dir = "./_local"; // TODO...
+
+    deferred = [&]() {
+        if (input_rec) input_rec_stop();
+        else input_rec_start(as_lower(dir + "/emu.input"));
+    };
+}
+
+
+void System::C64::input_rec_start(const std::string& filepath) {
+    input_rec_stop();
+
+    sys_snap.sid = sid.read_state();
+
+    input_rec.emplace();
+    input_rec->start_state = sys_snap.pack();
+    input_rec_path = filepath;
+
+    Log::info("Input recording: started");
+}
+
+
+void System::C64::input_rec_stop() {
+    if (!input_rec) return;
+
+    const Bytes data = input_rec->pack();
+
+    bool ok = false;
+    if (auto f = std::ofstream(input_rec_path, std::ios::binary)) {
+        f.write((const char*)data.data(), data.size());
+        ok = bool(f);
+    }
+
+    if (ok) Log::info("Input recorded: %s (%d events)", input_rec_path.c_str(), (int)input_rec->events.size());
+    else Log::error("Input recording failed: %s", input_rec_path.c_str());
+
+    input_rec.reset();
+}
+
+
+void System::C64::input_replay(Files::Input_log&& log) {
+    input_rec_stop();
+
+    if (!sys_snap.unpack(log.start_state)) return;
+
+    input_queue.assign(log.events.begin(), log.events.end());
+    replaying = !input_queue.empty();
+
+    sid.write_state(sys_snap.sid);
+    pre_run();
+    rewind_restart();
+
+    Log::info("Input replay: %d events", (int)log.events.size());
+}
+
+
+void System::C64::input_replay_stop() {
+    if (!replaying) return;
+
+    replaying = false;
+    input_queue.clear();
+
+    Log::info("Input replay: stopped");
+}
+
+
+bool System::C64::handle_file(Files::File& file, bool from_input) {
+    auto inject = [&](Byte_view data) {
         // load addr (used if 2nd.addr == 0)
-        s.ram[0xc3] = cpu.s.x;
-        s.ram[0xc4] = cpu.s.y;
+        ram_write(0xc3, cpu.s.x);
+        ram_write(0xc4, cpu.s.y);
 
         const u8 scnd_addr = s.ram[0xb9];
         u16 addr = (scnd_addr == 0)
@@ -743,21 +1060,22 @@ bool System::C64::handle_file(Files::File& file) {
             : data[1] * 0x100 + data[0];
 
         // 'load'
-        for (u32 b = 2; b < data.size(); ++b) s.ram[addr++] = data[b];
+        for (u32 b = 2; b < data.size(); ++b) ram_write(addr++, data[b]);
 
         // end pointer
-        s.ram[0xae] = cpu.s.x = addr;
-        s.ram[0xaf] = cpu.s.y = addr >> 8;
+        ram_write(0xae, cpu.s.x = addr);
+        ram_write(0xaf, cpu.s.y = addr >> 8);
     };
 
     using Type = Files::File::Type;
 
     // NOTE: 'crt' & 'sys_snap' loads are deferred, because otherwise we could be
     //       jumping in mid-cycle (because loading can be triggerd also by the cpu.tick())
+    auto& defer = from_input ? deferred_input : deferred;
     switch (file.type) {
         case Type::crt: {
             Log::info("CRT '%s' ...", file.name.c_str());
-            deferred = [&, name = file.name, data = std::move(file.data)]() {
+            defer = [&, name = file.name, data = std::move(file.data)]() {
                 Expansion::attach(s, name, Files::CRT{data});
                 reset_cold();
             };
@@ -778,11 +1096,20 @@ bool System::C64::handle_file(Files::File& file) {
             inject(file.data);
             return true;
         case Type::sys_snap: {
-            deferred = [&, d = std::move(file.data)]() {
-                Files::System_snapshot& iss = *((Files::System_snapshot*)d.data()); // brutal...
-                sys_snap.sys_state = iss.sys_state;
-                sid.core.write_state(iss.sid);
+            defer = [&, d = std::move(file.data)]() {
+                input_rec_stop(); // (neither would match the loaded state)
+                input_replay_stop();
+                if (!sys_snap.unpack(d)) return;
+                sid.write_state(sys_snap.sid);
                 pre_run(); // NOTE: required for now (see 'sid.h' for more info)
+                rewind_restart();
+            };
+            return true;
+        }
+        case Type::input_log: {
+            defer = [&, d = std::move(file.data)]() {
+                Files::Input_log log;
+                if (log.unpack(d)) input_replay(std::move(log));
             };
             return true;
         }
@@ -816,7 +1143,7 @@ void System::C64::do_load() {
 
         //'return' status to kernal routine
         cpu.s.clr(MOS6502::Flag::C); // no error
-        s.ram[0x90] = 0x00; // io status ok
+        ram_write(0x90, 0x00); // io status ok
     } else {
         cpu.s.pc = 0xf704; // --> file not found
     }
@@ -856,7 +1183,7 @@ void System::C64::do_save() {
     if (do_save(filepath, start_addr, &s.ram[start_addr], sz)) {
         // status
         cpu.s.clr(MOS6502::Flag::C); // no error
-        s.ram[0x90] = 0x00; // io status ok
+        ram_write(0x90, 0x00); // io status ok
         Log::info("Saved '%s', %d bytes", filepath.c_str(), int(sz + 2));
     } else {
         cpu.s.a = 0x07; // not output file
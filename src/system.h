@@ -2,7 +2,10 @@
 #define SYSTEM_H_INCLUDED
 
 
+#include <algorithm>
 #include <vector>
+#include <deque>
+#include <type_traits>
 #include "common.h"
 #include "state.h"
 #include "utils.h"
@@ -11,11 +14,14 @@
 #include "vic_ii.h"
 #include "sid.h"
 #include "cia.h"
+#include "scheduler.h"
 #include "c1541.h"
+#include "profile.h"
 #include "host.h"
 #include "menu.h"
 #include "files.h"
 #include "expansion.h"
+#include "rewind.h"
 
 
 
@@ -88,13 +94,47 @@ public:
     }
 
     void access(const u16& addr, u8& data, const State::System::Bus::RW rw) {
-        do_access(addr, data, rw);
+        if (s.pla.active != pages_pla) map_pages();
+
+        // plain RAM/ROM pages directly, the rest via 'do_access'
+        if (rw == State::System::Bus::RW::r) {
+            if (const u8* page = page_r[addr >> 8]) data = page[addr & 0xff];
+            else do_access(addr, data, rw);
+        } else {
+            written[addr >> 8] = true;
+            if (u8* page = page_w[addr >> 8]) page[addr & 0xff] = data;
+            else do_access(addr, data, rw);
+        }
+
         // TODO: a better (a more efficient) way of maintaining bus state?
         s.bus.addr = addr;
         s.bus.data = data;
         s.bus.rw = rw;
     }
 
+    // 'Plain' accesses only: RAM/ROM reads, and RAM writes outside of the VIC bank (i.e.
+    // accesses no other chip can see). Returns false (nothing accessed) for the rest.
+    bool access_plain(const u16& addr, u8& data, const State::System::Bus::RW rw) {
+        if (s.pla.active != pages_pla) map_pages();
+
+        if (rw == State::System::Bus::RW::r) {
+            const u8* page = page_r[addr >> 8];
+            if (!page) return false;
+            data = page[addr & 0xff];
+        } else {
+            u8* page = page_w[addr >> 8];
+            if (!page || (addr >> 14) == PLA::vic_array[s.pla.vic_bank][0]) return false;
+            page[addr & 0xff] = data;
+            written[addr >> 8] = true;
+        }
+
+        s.bus.addr = addr;
+        s.bus.data = data;
+        s.bus.rw = rw;
+
+        return true;
+    }
+
     u8 peek(const u16& addr) {
         using m = PLA::Mapping;
 
@@ -140,7 +180,42 @@ public:
 
     void col_ram_r(const u16& addr, u8& data) const { data = s.color_ram[addr]; }
 
+    bool written[0x100] = {}; // pages written (I/O included), for the rewind buffer (it clears these)
+
 private:
+    // Direct read/write pointers per 256 byte page (nullptr --> 'do_access'), rebuilt
+    // on the first access after a PLA config change (i.e. a 'update_pla()' call, via
+    // the IO port, exrom/game lines, or a state load).
+    const u8* page_r[0x100];
+    u8* page_w[0x100];
+    int pages_pla = -1;
+
+    void map_pages() {
+        using m = PLA::Mapping;
+
+        pages_pla = s.pla.active;
+
+        for (int page = 0x00; page <= 0xff; ++page) {
+            const u16 addr = page << 8;
+            const auto zone = page >> 4;
+
+            switch (PLA::array[pages_pla][State::System::Bus::RW::r][zone]) {
+                case m::ram0_r:  page_r[page] = page ? &s.ram[addr] : nullptr; break; // IO port at 0&1
+                case m::ram_r:   page_r[page] = &s.ram[addr];                  break;
+                case m::bas_r:   page_r[page] = &rom.basic[addr & 0x1fff];     break;
+                case m::kern_r:  page_r[page] = &rom.kernal[addr & 0x1fff];    break;
+                case m::charr_r: page_r[page] = &rom.charr[addr & 0x0fff];     break;
+                default:         page_r[page] = nullptr;                       break; // cart, IO, ...
+            }
+
+            switch (PLA::array[pages_pla][State::System::Bus::RW::w][zone]) {
+                case m::ram0_w:  page_w[page] = page ? &s.ram[addr] : nullptr; break;
+                case m::ram_w:   page_w[page] = &s.ram[addr];                  break;
+                default:         page_w[page] = nullptr;                       break;
+            }
+        }
+    }
+
     void do_access(const u16& addr, u8& data, const State::System::Bus::RW rw) {
         using m = PLA::Mapping;
         using bo = Expansion::Bus_op;
@@ -330,6 +405,51 @@ struct Performance {
         },
         {"Frame/8", "Frame/4", "Frame/2", "1 Frame"/*, "Frame/12"*//*, "Frame/24"*/},
     };
+
+    // CPU run-ahead in the unlimited/headless modes (see 'C64::run_ahead()')
+    Choice<bool> cpu_run_ahead{
+        {true, false},
+        {"On", "Off"},
+    };
+
+    // VIC line batching (see 'VIC_II::Core::Line_batch'), not when stepping
+    Choice<bool> vic_line_batching{
+        {true, false},
+        {"On", "Off"},
+    };
+
+    // in the unlimited mode, no VIC pixel output for the frames not shown
+    Choice<bool> warp_frame_skip{
+        {true, false},
+        {"On", "Off"},
+    };
+
+    // reSID on a worker thread (see 'reSID_Wrapper::threaded()'), not when headless
+    Choice<bool> sid_thread{
+        {false, true},
+        {"Off", "On"},
+        std::thread::hardware_concurrency() > 1,
+    };
+
+    // rewind buffer memory limit (MB), 0 --> off (see 'Rewind::Buffer')
+    Choice<int> rewind_mem{
+        {0, 16, 64, 256},
+        {"Off", "16 MB", "64 MB", "256 MB"},
+    };
+
+    // frames between the rewind keyframes
+    Choice<int> rewind_keyframe{
+        {25, 50, 100, 250},
+        {"0.5 s", "1 s", "2 s", "5 s"},
+        50,
+    };
+
+#ifdef PROFILE
+    Choice<bool> profile_overlay{
+        {false, true},
+        {"Off", "On"},
+    };
+#endif
 };
 
 
@@ -452,27 +572,84 @@ public:
 
     C64(const State::System::ROM& rom_) : rom(rom_)
     {
-        // intercept load/save for tape device
-        install_kernal_tape_traps(const_cast<u8*>(rom.kernal), Trap_OPC::tape_routine);
+        // intercept load/save for tape device (patching our own copy of the kernal)
+        install_kernal_tape_traps(rom.kernal, Trap_OPC::tape_routine);
 
         Expansion::detach(s);
     }
 
+    ~C64() { delete &sys_snap; }
+
+    C64(const C64&) = delete;
+    C64& operator=(const C64&) = delete;
+
     void run(Mode init_mode = Mode::clocked);
 
+    const State::System& state() const { return s; }
+
+    void drive_power(bool on) { c1541.power(on); }
+    void cpu_run_ahead(bool on) { perf.cpu_run_ahead = on; }
+    void vic_line_batching(bool on) { perf.vic_line_batching = on; }
+    void rewind_buffer(int mem_mb) { perf.rewind_mem = mem_mb; rewind_config(); } // 0 --> off
+
+    // input recorded from the start of the run, saved at the end (see 'Files::Input_log')
+    void record_input(const std::string& filepath) { input_rec_on_run = filepath; }
+
+    // headless: no VIC pixel output, i.e. 's.vic.frame' not updated (the VIC state stays exact)
+    void vic_pixel_output(bool on) {
+        headless_pixels = on;
+        if (s.mode == Mode::headless) vic.pixel_output(on);
+    }
+
+#ifdef HEADLESS
+    Host::Input& input() { return host_input; }
+    Host::Audio_out& audio_out() { return sid.audio_output(); }
+
+    // called at the end of each frame (in headless mode), returning 'false' stops the run
+    std::function<bool (State::System&)> frame_hook;
+
+    // (as noted since the frame was last handed over, see 'VIC_II::Core::changed')
+    VIC_II::Changed_lines& vic_changed_lines() { return vic.changed; }
+#endif
+
+#ifdef BENCH
+    enum class Chip : u8 { cpu, vic, cia, exp };
+
+    // a single chip tick, for timing the chips in isolation (see 'bench.cpp')
+    template<Chip chip>
+    void tick_chip() {
+        if constexpr (chip == Chip::cpu) {
+            bus.access(cpu.s.bus.a, cpu.s.bus.d, cpu.s.bus.rw);
+            cpu.tick();
+        }
+        if constexpr (chip == Chip::vic) vic.tick();
+        if constexpr (chip == Chip::cia) cia1.tick();
+        if constexpr (chip == Chip::exp) Expansion::tick(s, bus);
+    }
+#endif
+
 private:
     // Using the heap, since the default windows stack size is a bit small...
     Files::System_snapshot& sys_snap{*(new Files::System_snapshot)};
 
     // TODO: refactor this out?
-    const State::System::ROM& rom; // TODO: include in sys_snap (but make it optional)?
+    // NOTE: a copy, since the kernal gets patched (and the caller's ROMs can be shared
+    //       by several instances)
+    State::System::ROM rom; // TODO: include in sys_snap (but make it optional)?
 
     State::System& s{sys_snap.sys_state};
 
     CPU cpu{s.cpu, cpu_trap};
 
-    CIA cia1{s.cia1, cia1_pa_out, cia1_pb_out, int_hub.int_sig, IO::Int_sig::Src::cia1, s.vic.cycle};
-    CIA cia2{s.cia2, cia2_pa_out, cia2_pb_out, int_hub.int_sig, IO::Int_sig::Src::cia2, s.vic.cycle};
+    // run in this order when due at the same cycle
+    enum Event : Sched::Scheduler::Id { cia1_ev, cia2_ev, c1541_extra_ev, input_ev };
+
+    Sched::Scheduler sched;
+
+    CIA cia1{s.cia1, cia1_pa_out, cia1_pb_out, int_hub.int_sig, IO::Int_sig::Src::cia1, s.vic.cycle,
+                {sched, Event::cia1_ev}};
+    CIA cia2{s.cia2, cia2_pa_out, cia2_pb_out, int_hub.int_sig, IO::Int_sig::Src::cia2, s.vic.cycle,
+                {sched, Event::cia2_ev}};
 
     TheSID sid{int(FRAME_RATE_MIN), Performance::min_sync_points, s.vic.cycle};
 
@@ -480,6 +657,14 @@ private:
 
     Bus bus{s, rom, cia1, cia2, sid, vic};
 
+    Rewind::Buffer rewind{sys_snap, bus.written};
+    bool rewinding = false; // rewind key held
+
+    void ram_write(u16 addr, u8 data) { // by the host (i.e. not via the bus)
+        s.ram[addr] = data;
+        bus.written[addr >> 8] = true; // (for the rewind buffer)
+    }
+
     Int_hub int_hub{s.int_hub};
 
     Input_matrix input_matrix{s.input_matrix, cia1.port_a.ext_in, cia1.port_b.ext_in, vic.lp_line};
@@ -510,13 +695,11 @@ private:
     Host::Input::Handlers host_input_handlers{
         // TODO: just-in-time polling for keyboard/ctrl-ports? (i.e. when CIA1 regs are read)
 
-        // client keyboard & controllers (including lightpen)
-        input_matrix.keyboard,
-        input_matrix.ctrl_port_1,
-        input_matrix.ctrl_port_2,
-
-        // restore
-        [this](u8 down) { if (!down) int_hub.int_sig.set(IO::Int_sig::Src::rstr); },
+        // client keyboard & controllers (including lightpen), restore (see 'queue_input()')
+        [this](u8 code, u8 down) { queue_input({0, In_ev::keyboard, code, down, ""}); },
+        [this](u8 code, u8 down) { queue_input({0, In_ev::ctrl_port_1, code, down, ""}); },
+        [this](u8 code, u8 down) { queue_input({0, In_ev::ctrl_port_2, code, down, ""}); },
+        [this](u8 down) { queue_input({0, In_ev::restore, 0, down, ""}); },
     
         // system keys
         [this](u8 code, u8 down) {
@@ -527,6 +710,15 @@ private:
                     case ks::rst_cold:     reset_cold();                       break;
                     case ks::rst_warm:     reset_warm();                       break;
                     case ks::save_state:   save_state_req();                   break;
+                    case ks::rec_input:    input_rec_req();                    break;
+                    case ks::rewind:
+                        if (s.mode == Mode::stepped) {
+                            rewind_step();
+                            log_status();
+                        } else {
+                            rewinding = true;
+                        }
+                        break;
                     case ks::mode_stepped:
                         s.mode = (s.mode == Mode::stepped) ? Mode::clocked : Mode::stepped;
                         break;
@@ -565,17 +757,21 @@ private:
             } else {
                 if (code == ks::sys) menu.active = show_status = false;
                 else if (code == ks::mode_unlimited) s.mode = Mode::clocked;
+                else if (code == ks::rewind) rewinding = false;
             }
         },
 
-        // file drop
+        // file drop (states & input logs directly, the rest as input)
         [this](const char* filepath) {
+            using Type = Files::File::Type;
             Log::info("Incoming: '%s'", filepath);
             auto file = Files::read(filepath);
-            if (file.identified() && file.type != Files::File::Type::c64_bin) {
+            if (!file.identified() || file.type == Type::c64_bin) {
+                Log::info("Ignored: '%s'", filepath);
+            } else if (file.type == Type::sys_snap || file.type == Type::input_log) {
                 handle_file(file);
             } else {
-                Log::info("Ignored: '%s'", filepath);
+                queue_input({0, In_ev::drop, 0, 0, filepath, std::move(file.data)});
             }
         },
 
@@ -583,7 +779,11 @@ private:
         vid_out.window_resized,
     };
 
+#ifdef HEADLESS
+    Host::Input host_input{host_input_handlers, s.vic.cycle};
+#else
     Host::Input host_input{host_input_handlers};
+#endif
 
     // TODO: verify that it is a valid kernal trap (e.g. 'addr_space.mapping(cpu.pc) == kernal')
     MOS6502::Sig_halt cpu_trap{
@@ -622,23 +822,93 @@ private:
 
     Performance perf{};
 
-    _Stopwatch watch;
+    Profile::Profiler prof;
     Timer frame_timer;
 
     bool show_status = false;
+    bool headless_pixels = true;
+
+    Files::Snapshot_saver state_saver;
+    int state_saver_msg_timer = 0; // frames
+
+    using In_ev = Files::Input_log::Event;
+
+    /*  All the input to the C64 (see 'Files::Input_log') gets queued, stamped with the
+        next cycle, and is fed in by the scheduler ('input_ev'). I.e. the same way as
+        when replayed, and so the replay is exact. When replaying, the rest is ignored.
+    */
+    std::deque<In_ev> input_queue;
+    bool replaying = false;
+    Maybe<Files::Input_log> input_rec; // recording, if set
+    std::string input_rec_path;
+    std::string input_rec_on_run;
+
+    void queue_input(In_ev ev);
+    void run_input();
+
+    void input_rec_req(); // start/stop recording (to the default file)
+    void input_rec_start(const std::string& filepath);
+    void input_rec_stop();
+    void input_replay(Files::Input_log&& log);
+    void input_replay_stop();
+
+    void rewind_config() {
+        sys_snap.sid = sid.read_state(); // (for the starting point)
+        rewind.configure(std::size_t(perf.rewind_mem) * 1024 * 1024, perf.rewind_keyframe);
+    }
+    void rewind_restart() { // a new history, starting from the current state
+        sys_snap.sid = sid.read_state();
+        rewind.restart();
+    }
+    void rewind_frame(); // at the frame end: record, or step back (if rewinding)
+    void rewind_step();
+    void state_rewound();
 
     std::function<void()> deferred;
+    std::function<void()> deferred_input; // loads from the input (drops): at a frame end only
     void check_deferred();
 
     void log_status();
 
     void pre_run();
 
-    void run_cycle();
+    bool sid_threaded() const { return perf.sid_thread && s.mode != Mode::none && s.mode != Mode::headless; }
+
+    // Attached (cycle consuming) hardware. Each combination gets its own run loop,
+    // with the checks for absent hardware compiled out.
+    enum Run_cfg : u8 {
+        bare = 0b00, c1541_on = 0b01, exp_on = 0b10, full = 0b11,
+    };
+
+    u8 run_cfg() const {
+        return (c1541.powered() ? Run_cfg::c1541_on : 0)
+                | (s.exp.type != Expansion::Type::none ? Run_cfg::exp_on : 0);
+    }
+
+    template<typename F>
+    void dispatch_run_cfg(F&& f) {
+        switch (run_cfg()) {
+            case Run_cfg::bare:     f(std::integral_constant<u8, Run_cfg::bare>{});     break;
+            case Run_cfg::c1541_on: f(std::integral_constant<u8, Run_cfg::c1541_on>{}); break;
+            case Run_cfg::exp_on:   f(std::integral_constant<u8, Run_cfg::exp_on>{});   break;
+            case Run_cfg::full:     f(std::integral_constant<u8, Run_cfg::full>{});     break;
+        }
+    }
+
+    template<u8 cfg> void run_cycle();
+    template<u8 cfg> void run_events();
+    template<u8 cfg> bool run_ahead();
+    void run_cycle() { dispatch_run_cfg([this](auto cfg) { run_cycle<decltype(cfg)::value>(); }); }
+
+    // 'cfg' loops return when the mode, or the run config changes
+    template<u8 cfg> void run_clocked();
+    template<u8 cfg> void run_unlimited();
+    template<u8 cfg> void run_headless();
 
     void run_clocked();
     void run_stepped();
     void run_unlimited();
+    void run_headless();
 
     void step_forward(u8 key_code);
 
@@ -649,7 +919,7 @@ private:
 
     void save_state_req();
 
-    bool handle_file(Files::File& file);
+    bool handle_file(Files::File& file, bool from_input = false);
 
     void do_load();
     void do_save();
@@ -696,6 +966,23 @@ private:
                 sid.reconfig(perf.latency.chosen.audio_buf_sz);
             }
         },
+        {"CPU run-ahead", perf.cpu_run_ahead, [](){}},
+        {"Warp frame skip", perf.warp_frame_skip,
+            [&]() {
+                if (!perf.warp_frame_skip) vic.pixel_output(true);
+            }
+        },
+        {"VIC line batching", perf.vic_line_batching,
+            [&]() {
+                vic.line_batching(perf.vic_line_batching && s.mode != Mode::stepped);
+            }
+        },
+        {"SID thread", perf.sid_thread, [&]() { sid.threaded(sid_threaded()); }},
+        {"Rewind buffer", perf.rewind_mem, [&]() { rewind_config(); }},
+        {"Rewind keyframes", perf.rewind_keyframe, [&]() { rewind_config(); }},
+#ifdef PROFILE
+        {"Profile overlay", perf.profile_overlay, [](){}},
+#endif
     };
 
     Menu menu{
@@ -715,34 +1002,98 @@ private:
     static void install_kernal_tape_traps(u8* kernal, u8 trap_opc);
 };
 
-inline
-void C64::run_cycle() {
+template<u8 cfg>
+inline void C64::run_cycle() {
     using RW = MOS6502::Core::State::Bus::RW;
 
+    constexpr bool with_c1541 = cfg & Run_cfg::c1541_on;
+    constexpr bool with_exp = cfg & Run_cfg::exp_on;
+
     vic.tick();
 
     if (cpu.s.bus.rw == RW::w) {
-        c1541.tick();
+        if constexpr (with_c1541) c1541.tick();
         bus.access(cpu.s.bus.a, cpu.s.bus.d, cpu.s.bus.rw);
         cpu.tick();
     } else {
         if (s.ba || s.dma) {
-            c1541.tick();
+            if constexpr (with_c1541) c1541.tick();
         } else {
             bus.access(cpu.s.bus.a, cpu.s.bus.d, cpu.s.bus.rw);
             cpu.tick();
-            c1541.tick();
+            if constexpr (with_c1541) c1541.tick();
         }
     }
 
-    Expansion::tick(s, bus);
+    if constexpr (with_exp) Expansion::tick(s, bus);
 
-    cia1.tick();
-    cia2.tick();
+    if (sched.pending(s.vic.cycle)) run_events<cfg>();
 
     int_hub.tick(cpu);
+}
+
+
+template<u8 cfg>
+inline void C64::run_events() {
+    constexpr bool with_c1541 = cfg & Run_cfg::c1541_on;
+
+    sched.run(s.vic.cycle, [this](Sched::Scheduler::Id ev) {
+        switch (ev) {
+            case Event::cia1_ev: cia1.tick(); return;
+            case Event::cia2_ev: cia2.tick(); return;
+            case Event::input_ev: run_input(); return;
+            case Event::c1541_extra_ev: {
+                constexpr u64 freq = C1541::extra_cycle_freq;
+                if constexpr (with_c1541) {
+                    if (s.vic.cycle % freq == 0) c1541.tick();
+                }
+                sched.at(Event::c1541_extra_ev, (s.vic.cycle / freq + 1) * freq);
+                return;
+            }
+        }
+    });
+}
+
+
+/*  CPU run-ahead: the CPU is run alone (doing only 'plain' bus accesses), and then the
+    VIC catches up. Nothing else can observe or affect the CPU during such a span, i.e.
+    the span:
+      - is within the VIC quiet line cycles, and starts with BA inactive and the VIC IRQ
+        output steady (so BA & IRQ lines stay as they are, unless the VIC is written)
+      - ends before the next scheduled event (CIAs, ...)
+      - ends at the first access that is not 'plain' (IO, a write the VIC might see, ...),
+        or at a CPU halt (a trap may access anything)
+    Hence, the results are identical to per cycle stepping. The drive runs in lockstep
+    with the CPU (it only sees the CIA2 port, which can not change during the span).
+    Returns false if no cycles could be run.
+*/
+template<u8 cfg>
+inline bool C64::run_ahead() {
+    constexpr bool with_c1541 = cfg & Run_cfg::c1541_on;
+    constexpr bool with_exp = cfg & Run_cfg::exp_on;
+
+    if constexpr (with_exp) return false; // may observe the bus, or do DMA
+
+    const u64 cycle = s.vic.cycle;
+    const int line_cycle = (cycle + 1) % LINE_CYCLE_COUNT;
+    const u64 next_event = sched.next_due();
+
+    if (line_cycle < VIC::quiet_first || line_cycle > VIC::quiet_last) return false;
+    if (s.ba || s.dma || !vic.irq_steady() || next_event <= (cycle + 1)) return false;
+
+    const u64 last = std::min(cycle + 1 + (VIC::quiet_last - line_cycle), next_event - 1);
+
+    int ahead = 0;
+    for (u64 c = cycle + 1; c <= last; ++c) {
+        if (cpu.halted() || !bus.access_plain(cpu.s.bus.a, cpu.s.bus.d, cpu.s.bus.rw)) break;
+        cpu.tick();
+        if constexpr (with_c1541) c1541.tick();
+        ++ahead;
+    }
+
+    for (int c = 0; c < ahead; ++c) vic.tick();
 
-    if (s.vic.cycle % C1541::extra_cycle_freq == 0) c1541.tick();
+    return ahead > 0;
 }
 
 
@@ -1,6 +1,8 @@
 #ifndef TEST_H_INCLUDED
 #define TEST_H_INCLUDED
 
+#include <map>
+
 
 namespace Test {
 
@@ -186,6 +188,159 @@ exit:
 }
 
 
+#ifdef HEADLESS
+/*  A minimal kernal (i.e. no ROM files needed): CIA1 timer IRQs counted (at $02), with
+    'irq_xtra' run in the IRQ handler, and a busy loop.
+*/
+std::unique_ptr<State::System::ROM> test_roms(std::initializer_list<u8> irq_xtra = {}) {
+    auto roms = std::make_unique<State::System::ROM>();
+    {
+        static constexpr u16 kernal_start = 0xe000;
+
+        std::vector<u8> code;
+        auto emit = [&](std::initializer_list<u8> bytes) { code.insert(code.end(), bytes); };
+        auto poke = [&](u16 addr, u8 val) { emit({0xa9, val, 0x8d, u8(addr), u8(addr >> 8)}); };
+        auto addr = [&]() { return u16(kernal_start + code.size()); };
+
+        emit({0x78, 0xa2, 0xff, 0x9a}); // sei, ldx #$ff, txs
+        poke(0x0001, 0x37);
+        poke(0x0000, 0x2f);
+        poke(0xd011, 0x1b); // VIC: display on
+        poke(0xdc0d, 0x7f); // CIA1: all ints off, timer A: $4025, ints on, start (continuous)
+        poke(0xdc04, 0x25);
+        poke(0xdc05, 0x40);
+        poke(0xdc0d, 0x81);
+        poke(0xdc0e, 0x11);
+        emit({0x58}); // cli
+        const u16 loop = addr();
+        emit({0xe6, 0x03, 0xd0, 0xfc, 0xe6, 0x04, 0x4c, u8(loop), u8(loop >> 8)}); // inc $03, bne, inc $04, jmp
+        const u16 irq = addr();
+        emit({0x48, 0xad, 0x0d, 0xdc, 0xe6, 0x02}); // pha, lda $dc0d, inc $02
+        emit(irq_xtra);
+        emit({0x68, 0x40}); // pla, rti
+        const u16 nmi = addr();
+        emit({0x40}); // rti
+
+        std::copy(code.begin(), code.end(), roms->kernal);
+        for (const auto& [vec, to] : { std::pair<u16, u16>{0xfffa, nmi}, {0xfffc, kernal_start}, {0xfffe, irq} }) {
+            roms->kernal[vec - kernal_start] = to;
+            roms->kernal[vec - kernal_start + 1] = to >> 8;
+        }
+    }
+
+    return roms;
+}
+
+
+/*  Rewind to the start: the 'rewind' key is held until the history runs out (i.e. back to
+    the state right after the power-on reset), after which the run must reconverge with an
+    uninterrupted one (same RAM at the same cycle).
+*/
+bool run_rewind_test() {
+    static constexpr u64 frames = 300;
+    static constexpr u64 rewind_from = 100; // frame
+    static constexpr u64 rewind_held = rewind_from + 20; // frames (i.e. beyond the start)
+
+    const auto roms = test_roms();
+
+    auto ram_hash = [](const State::System& s) {
+        u64 h = 0xcbf29ce484222325;
+        for (const u8 b : s.ram) h = (h ^ b) * 0x100000001b3;
+        return h;
+    };
+
+    std::map<u64, u64> expected; // cycle --> RAM hash
+    {
+        System::C64 c64(*roms);
+        c64.drive_power(false);
+        c64.rewind_buffer(16);
+        u64 frame = 0;
+        c64.frame_hook = [&](State::System& s) {
+            expected[s.vic.cycle] = ram_hash(s);
+            return ++frame < frames;
+        };
+        c64.run(System::C64::Mode::headless);
+    }
+
+    System::C64 c64(*roms);
+    c64.drive_power(false);
+    c64.rewind_buffer(16);
+    auto& input = c64.input();
+
+    using Event = Host::Input::Event;
+    u64 frame = 0;
+    int checked = 0;
+    int failed = 0;
+    c64.frame_hook = [&](State::System& s) {
+        ++frame;
+        if (frame == rewind_from) {
+            input.push({s.vic.cycle, Event::key, Key_code::System::rewind, true, ""});
+        } else if (frame == rewind_from + rewind_held) {
+            input.push({s.vic.cycle, Event::key, Key_code::System::rewind, false, ""});
+        } else if (frame > rewind_from + rewind_held) {
+            if (const auto e = expected.find(s.vic.cycle); e != expected.end()) {
+                ++checked;
+                if (e->second != ram_hash(s)) ++failed;
+            }
+        }
+        return frame < rewind_from + rewind_held + frames;
+    };
+    c64.run(System::C64::Mode::headless);
+
+    const bool pass = checked > 0 && failed == 0;
+    Log::info("Rewind test: %s (frames checked: %d, failed: %d)", pass ? "PASS" : "FAIL", checked, failed);
+    return pass;
+}
+
+
+/*  The changed lines noted by the VIC vs. the actual frame to frame differences (none may
+    be missed), with the border & background colors changed by the IRQs (i.e. mid-frame).
+    With & without the line batching, and the CPU run-ahead.
+*/
+bool run_changed_lines_test() {
+    static constexpr u64 frames = 200;
+
+    const auto roms = test_roms({
+        0xad, 0x11, 0xd0, 0x49, 0x08, 0x8d, 0x11, 0xd0, // lda $d011, eor #$08, sta $d011 (24/25 rows)
+        0xa5, 0x02, 0x29, 0x0f, 0xd0, 0x06, // lda $02, and #$0f, bne +6 (i.e. at every 16th IRQ:)
+        0xee, 0x20, 0xd0, 0xee, 0x21, 0xd0, // inc $d020, inc $d021
+    });
+
+    int changed = 0; // lines
+    int missed = 0;
+    int extra = 0; // (noted, but no difference)
+    for (const bool fast : { false, true }) {
+        System::C64 c64(*roms);
+        c64.drive_power(false);
+        c64.vic_line_batching(fast);
+        c64.cpu_run_ahead(fast);
+
+        auto prev = std::make_unique<u8[]>(VIC_II::FRAME_SIZE);
+        auto& lines = c64.vic_changed_lines();
+        u64 frame = 0;
+        c64.frame_hook = [&](State::System& s) {
+            for (int y = 0; y < VIC_II::FRAME_HEIGHT; ++y) {
+                const auto pos = y * VIC_II::FRAME_WIDTH;
+                const bool diff = std::memcmp(&s.vic.frame[pos], &prev[pos], VIC_II::FRAME_WIDTH) != 0;
+                if (diff) ++changed;
+                if (diff && !lines.line[y]) ++missed;
+                if (!diff && lines.line[y]) ++extra;
+            }
+            std::memcpy(prev.get(), s.vic.frame, VIC_II::FRAME_SIZE);
+            lines.none();
+            return ++frame < frames;
+        };
+        c64.run(System::C64::Mode::headless);
+    }
+
+    const bool pass = changed > 0 && missed == 0;
+    Log::info("Changed lines test: %s (lines changed: %d, missed: %d, extra: %d)",
+                pass ? "PASS" : "FAIL", changed, missed, extra);
+    return pass;
+}
+#endif // HEADLESS
+
+
 } // namespace Test
 
 
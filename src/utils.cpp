@@ -6,6 +6,14 @@
 #include <iomanip>
 #include <sstream>
 #include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 
 
@@ -125,6 +133,48 @@ int read_file(const std::string& filepath, u8* buf) {
 }
 
 
+Maybe<Blob> Blob::map_file(const std::string& filepath) {
+    auto mapped = [&](void* addr, std::size_t size, auto unmap) {
+        Blob blob;
+        blob.owner = std::shared_ptr<const void>(addr, unmap);
+        blob.ptr = (const u8*)addr;
+        blob.len = size;
+        return blob;
+    };
+
+#ifdef _WIN32
+    HANDLE f = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER sz;
+        HANDLE m = (GetFileSizeEx(f, &sz) && sz.QuadPart > 0)
+                        ? CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        CloseHandle(f);
+        if (m) {
+            void* addr = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(m); // (the view keeps it)
+            if (addr) return mapped(addr, sz.QuadPart, [](void* a) { UnmapViewOfFile(a); });
+        }
+    }
+#else
+    if (const int fd = open(filepath.c_str(), O_RDONLY); fd >= 0) {
+        struct stat st;
+        void* addr = (fstat(fd, &st) == 0 && st.st_size > 0)
+                        ? mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        close(fd); // (the mapping stays)
+        if (addr != MAP_FAILED) {
+            const std::size_t size = st.st_size;
+            return mapped(addr, size, [size](void* a) { munmap(a, size); });
+        }
+    }
+#endif
+
+    if (auto bytes = read_file(filepath); bytes) return Blob(std::move(*bytes));
+
+    return {};
+}
+
+
 std::string as_lower(const std::string& src) {
     std::string dst(src);
     std::transform(src.begin(), src.end(), dst.begin(), ::tolower);
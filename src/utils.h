@@ -2,18 +2,18 @@
 #define UTILS_H_INCLUDED
 
 #include <string>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <thread>
 #include <iostream>
 #include <cmath>
+#include <memory>
 #ifdef __MINGW32__
 #include <windows.h>
 #endif
 #include "common.h"
 
-#ifdef _WIN32
-#include "profileapi.h"
-#endif
 
 
 #define UNUSED(x) (void)(x)
@@ -29,7 +29,7 @@ public:
 
     void reset() { clock_start = clock::now(); }
 
-    int elapsed() const {
+    i64 elapsed() const { // (64 bit: an 'int' of microseconds would wrap in ~36 minutes)
         return std::chrono::duration_cast<us>(clock::now() - clock_start).count();
     }
 
@@ -47,67 +47,111 @@ private:
 };
 
 
-
-class _Stopwatch { public: void start() {} void stop() {} void reset() {} };
-
-#ifdef _WIN32
-class Stopwatch {
+/*  Lock-free single producer/single consumer ring (holds up to N - 1 items).
+    Items are accessed in place: the producer fills 'back()' & then 'push()'es it, the
+    consumer uses 'front()' & then 'pop()'s it (i.e. the item stays valid until popped).
+    Or in bulk (copying), with 'write()' & 'read()'.
+*/
+template<typename T, u32 N>
+class SPSC_ring {
 public:
-    Stopwatch() {
-        QueryPerformanceFrequency(&li);
-        freq = li.QuadPart;
-        start();
+    // producer
+    bool full() const { return next(head.load(rlx)) == tail.load(acq); }
+    T& back() { return items[head.load(rlx)]; }
+    void push() { head.store(next(head.load(rlx)), rel); }
+    const T& last_pushed() const { return items[(head.load(rlx) + N - 1) % N]; } // (never written to)
+    u32 write(const T* from, u32 n) { // returns the count written (i.e. until full)
+        const u32 h = head.load(rlx);
+        n = std::min(n, (tail.load(acq) + N - h - 1) % N);
+        const u32 n1 = std::min(n, N - h);
+        std::copy(from, from + n1, items + h);
+        std::copy(from + n1, from + n, items);
+        head.store((h + n) % N, rel);
+        return n;
     }
-    ~Stopwatch() {
-        Log::info("Stopwatch, total avg: %d", (total_elapsed / total_n));
+
+    // consumer
+    bool empty() const { return tail.load(rlx) == head.load(acq); }
+    T& front() { return items[tail.load(rlx)]; }
+    void pop() { tail.store(next(tail.load(rlx)), rel); }
+    u32 read(T* to, u32 n) { // returns the count read (i.e. until empty)
+        const u32 t = tail.load(rlx);
+        n = std::min(n, (head.load(acq) + N - t) % N);
+        const u32 n1 = std::min(n, N - t);
+        std::copy(items + t, items + t + n1, to);
+        std::copy(items, items + (n - n1), to + n1);
+        tail.store((t + n) % N, rel);
+        return n;
     }
 
-    void start() { QueryPerformanceCounter(&li); t0 = li.QuadPart; }
+    // either side
+    u32 size() const { return (head.load(acq) + N - tail.load(acq)) % N; }
+
+private:
+    static constexpr auto rlx = std::memory_order_relaxed;
+    static constexpr auto acq = std::memory_order_acquire;
+    static constexpr auto rel = std::memory_order_release;
+
+    static u32 next(u32 i) { return (i + 1) % N; }
+
+    T items[N];
+
+    alignas(64) std::atomic<u32> head{0}; // written by the producer
+    alignas(64) std::atomic<u32> tail{0}; // written by the consumer
+};
+
 
-    void stop() {
-        QueryPerformanceCounter(&li);
-        cur_elapsed += (((li.QuadPart - t0) * 1000000) / freq);
-        t0 = li.QuadPart;
-    }
 
-    void reset() {
-        total_elapsed += cur_elapsed;
-        hist[total_n % hist_len] = cur_elapsed;
-        ++total_n;
-        cur_elapsed = 0;
-
-        if ((total_n % 100) == 0) {
-            auto avg = [&](int win_sz) {
-                int64_t sum = 0;
-                for (int i = 1; i <= win_sz; ++i) {
-                    sum += hist[((total_n + hist_len) - i) % hist_len];
-                }
-                return sum / win_sz;
-            };
-            std::cout << avg(100);
-            if ((total_n % 200) == 0) std::cout << ' ' << avg(200);
-            if ((total_n % 400) == 0) std::cout << ' ' << avg(400);
-            if ((total_n % 800) == 0) std::cout << ' ' << avg(800);
-            std::cout << std::endl;
-        }
-
-        start();
-    }
+
+
+// Read-only view of bytes (not owning), e.g. of a 'Bytes' or a 'Blob'
+class Byte_view {
+public:
+    Byte_view(const u8* data_, std::size_t size_) : ptr(data_), len(size_) {}
+    Byte_view(const Bytes& bytes) : ptr(bytes.data()), len(bytes.size()) {}
+
+    const u8* data() const { return ptr; }
+    std::size_t size() const { return len; }
+    const u8* begin() const { return ptr; }
+    const u8* end() const { return ptr + len; }
+    const u8& operator[](std::size_t i) const { return ptr[i]; }
 
 private:
-    static constexpr int hist_len = 800;
+    const u8* ptr;
+    std::size_t len;
+};
 
-    LARGE_INTEGER li;
-    decltype(li.QuadPart) t0;
-    int freq;
 
-    int cur_elapsed = 0;
-    int total_n = 0;
-    int64_t total_elapsed = 0;
+/*  Read-only bytes, either a memory mapped file (i.e. nothing gets copied, the pages
+    are read in on demand), or owned 'Bytes'. Copies share the contents.
+    NOTE: a mapped file should not be modified (truncated) while in use.
+*/
+class Blob {
+public:
+    Blob() = default;
+    Blob(Bytes bytes) {
+        auto b = std::make_shared<const Bytes>(std::move(bytes));
+        ptr = b->data();
+        len = b->size();
+        owner = std::move(b);
+    }
+
+    // falls back to reading the file, if mapping fails
+    static Maybe<Blob> map_file(const std::string& filepath);
+
+    const u8* data() const { return ptr; }
+    std::size_t size() const { return len; }
+    const u8* begin() const { return ptr; }
+    const u8* end() const { return ptr + len; }
+    const u8& operator[](std::size_t i) const { return ptr[i]; }
 
-    int hist[hist_len] = {};
+    operator Byte_view() const { return {ptr, len}; }
+
+private:
+    std::shared_ptr<const void> owner; // the mapping, or the 'Bytes'
+    const u8* ptr = nullptr;
+    std::size_t len = 0;
 };
-#endif
 
 
 // Colodore by pepto - http://www.pepto.de/projects/colorvic/
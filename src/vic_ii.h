@@ -1,8 +1,11 @@
 #ifndef VIC_II_H_INCLUDED
 #define VIC_II_H_INCLUDED
 
+#include <algorithm>
+#include <cstring>
 #include "common.h"
 #include "state.h"
+#include "vic_ii_simd.h"
 
 
 namespace VIC_II {
@@ -34,6 +37,38 @@ struct CR2 {
 };
 
 
+// 8 pixels as bits (pixel 0 at bit 7) --> as bytes (0x00/0xff, in frame buffer order)
+inline const struct Px_bytes {
+    static constexpr u64 bcast = 0x0101010101010101; // u8 --> 8 bytes
+
+    u64 of[256];
+
+    Px_bytes() {
+        for (int bits = 0; bits < 256; ++bits) {
+            u8 px[8];
+            for (int p = 0; p < 8; ++p) px[p] = (bits & (0x80 >> p)) ? 0xff : 0x00;
+            std::memcpy(&of[bits], px, 8);
+        }
+    }
+} px_bytes;
+
+
+// The frame lines changed since the frame was handed over (to the video out)
+struct Changed_lines {
+    bool line[FRAME_HEIGHT];
+
+    Changed_lines() { all(); } // (nothing shown yet)
+
+    void at(u32 pos) { line[pos / FRAME_WIDTH] = true; }
+    void at(u32 pos_from, u32 pos_to) { // [from, to)
+        std::fill(&line[pos_from / FRAME_WIDTH], &line[(pos_to - 1) / FRAME_WIDTH + 1], true);
+    }
+
+    void all()  { std::fill(std::begin(line), std::end(line), true); }
+    void none() { std::fill(std::begin(line), std::end(line), false); }
+};
+
+
 template<typename Bus>
 class Core { // 6569 (PAL-B)
 public:
@@ -44,7 +79,7 @@ public:
           u16& ba_, IO::Int_sig& int_sig)
         : s(s_),
           bus(bus_), irq(s, int_sig), ba(ba_), lp(s, irq),
-          mobs(s, bus, ba, irq), gfx(s, bus, ba), border(s) {}
+          mobs(s, bus, ba, irq), gfx(s, bus, ba), border(s, changed) {}
 
     void reset();
 
@@ -66,6 +101,9 @@ public:
     }
 
     void w(const u8& ri, const u8& data) {
+        flush_batch();
+        w_cycle = s.cycle;
+
         u8 d = data & ~reg_unused[ri];
         s.reg[ri] = d;
 
@@ -106,6 +144,27 @@ public:
 
     void tick();
 
+    void line_batching(bool on) { flush_batch(); batch.enabled = on; }
+
+    // off: no pixels (i.e. 's.frame' not updated), but otherwise all the same (collisions, etc.)
+    void pixel_output(bool on) { flush_batch(); pixels = border.pixels = on; }
+
+    /*  Noted as the pixels get output (when they differ from what was there). The other
+        writers of 's.frame' (the overlays, a state restore, ...) note their changes too.
+    */
+    Changed_lines changed;
+
+    // Line cycles during which BA can not go low, nor a raster IRQ happen (unless the
+    // registers get written), see 'C64::run_ahead()'
+    static constexpr int quiet_first = 12;
+    static constexpr int quiet_last  = 53;
+
+    // IRQ output can not change during the quiet cycles (i.e. it is active already,
+    // or the mid-line sources are disabled)
+    bool irq_steady() const {
+        return (s.reg[R::ireg] & IRQ::irq) || !(s.reg[R::ien] & (IRQ::mdc | IRQ::mmc | IRQ::lp));
+    }
+
 private:
 
     class IRQ {
@@ -221,13 +280,15 @@ private:
             s.data = (d1 << 24) | (d2 << 16) | (d3 << 8) | Data_status::waiting;
         }
 
-        // during blanking
-        void update(u16 px, const u8 mob_bit, u8* mob_presence, u8& mmc) {
+        /*  Shifts out the pixels of a cycle (from the raster x 'px' on), as color index
+            bit-planes (pixel 0 at bit 7, 'hi' for col.2/3, 'lo' for col.1/3, none being
+            transparent). Returns 'false' if none (not displaying yet).
+        */
+        bool shift_out(u16 px, u8& hi, u8& lo) {
             if (is_waiting()) {
                 if (!is_scheduled()) {
-                    if (s.x < px || (s.x >= (px + 8))) return;
-                    schedule(s.x - px);
-                    return;
+                    if (s.x >= px && (s.x < (px + 8))) schedule(s.x - px);
+                    return false;
                 } else {
                     px = s.shift_timer;
                     release();
@@ -236,61 +297,32 @@ private:
                 px = 0;
             }
 
-            for (; px < 8; ++px) {
-                const u8 p_col = s.col[(s.data >> 30) & s.pixel_mask];
+            hi = lo = 0b00000000;
 
-                if (p_col != transparent) {
-                    if (mob_presence[px]) mmc |= (mob_presence[px] | mob_bit);
-                    mob_presence[px] |= mob_bit;
-                }
-
-                if ((++s.shift_timer % s.shift_delay) == 0) {
-                    s.data <<= s.shift_amount;
-                    if (!s.data) return;
-                }
-            }
-
-            s.shift_delay = s.shift_base_delay * s.shift_amount;
-        }
-
-        void output(u16 px, const u8* gfx_out, const u8 mdp,
-                        const u8 mob_bit, u8* mob_output, u8* mob_presence,
-                        u8& mdc, u8& mmc)
-        {
-            if (is_waiting()) {
-                if (!is_scheduled()) {
-                    if (s.x < px || (s.x >= (px + 8))) return;
-                    schedule(s.x - px);
-                    return;
-                } else {
-                    px = s.shift_timer;
-                    release();
-                }
+            // hires & not expanded, i.e. a bit per pixel ('shift_delay' lags a mid-line mc change)
+            if (s.shift_delay == 1 && s.shift_amount == 1) {
+                hi = u8(s.data >> 24) >> px;
+                s.shift_timer += 8 - px;
+                s.data <<= 8 - px;
+                if (!s.data) return true;
             } else {
-                px = 0;
-            }
-
-            for (; px < 8; ++px) {
-                const u8 p_col = s.col[(s.data >> 30) & s.pixel_mask];
-
-                if (p_col != transparent) {
-                    if (mob_presence[px]) mmc |= (mob_presence[px] | mob_bit);
-                    mob_presence[px] |= mob_bit;
-
-                    if (gfx_out[px] & GFX::foreground) mdc |= mob_bit;
-
-                    mob_output[px] = p_col | mdp;
-                }
-
-                if ((++s.shift_timer % s.shift_delay) == 0) {
-                    s.data <<= s.shift_amount;
-                    if (!s.data) return;
+                for (u8 pb = 0x80 >> px; pb; pb >>= 1) {
+                    const u8 ci = (s.data >> 30) & s.pixel_mask;
+                    if (ci & 0b10) hi |= pb;
+                    if (ci & 0b01) lo |= pb;
+
+                    if ((++s.shift_timer & (s.shift_delay - 1)) == 0) { // (delay is 1, 2 or 4)
+                        s.data <<= s.shift_amount;
+                        if (!s.data) return true;
+                    }
                 }
             }
 
             // NOTE: this comes a few pixels late (should be done
             //       inside the loop above, but meh..)
             s.shift_delay = s.shift_base_delay * s.shift_amount;
+
+            return true;
         }
 
     private:
@@ -390,62 +422,82 @@ private:
               ba(ba_), irq(irq_) {}
 
     private:
+        // (the per mob pixel bits from 'shift_out()' are combined a cycle at a time)
         void _update(int start_mn, u16 x) {
+            u8 any = 0b00000000;   // pixels with a mob
+            u8 multi = 0b00000000; // pixels with more than one mob
+            u8 present[mob_count] = {};
+
             for (int mn = start_mn; mn < mob_count; ++mn) {
-                if (mob[mn].data) {
-                    const u8 mob_bit = 0b1 << mn;
-                    MOB{mob[mn]}.update(x, mob_bit, mob_presence, mmc);
+                u8 hi, lo;
+                if (mob[mn].data && MOB{mob[mn]}.shift_out(x, hi, lo)) {
+                    present[mn] = hi | lo;
+                    multi |= any & present[mn];
+                    any |= present[mn];
                 }
             }
 
-            if (mmc) {
-                if (reg[R::mnm] == 0b00000000) irq.req(IRQ::mmc);
-                reg[R::mnm] |= mmc;
-                mmc = 0b00000000;
-            }
-
-            for (int p = 0; p < 8; ++p) mob_presence[p] = 0b00000000;
+            if (multi) mob_mob_collision(present, multi);
         }
 
         void _output(int start_mn, u16 x, u8* to) { // also does collision detection
+            static constexpr u64 fg_bits = Px_bytes::bcast * GFX::foreground;
+
+            u64 gfx;
+            std::memcpy(&gfx, to, 8);
+            const u64 gfx_fg = ((gfx & fg_bits) >> 7) * 0xff;
+
+            u8 any = 0b00000000;
+            u8 multi = 0b00000000;
+            u8 present[mob_count] = {};
+            u64 out = 0; // the lowest numbered mob on top
+            u8 mdc = 0b00000000; // mob-gfx colliders
+
             for (int mn = start_mn; mn >= 0; --mn) {
-                if (mob[mn].data) {
-                    const u8 mob_bit = 0b1 << mn;
-                    const u8 mdp = (reg[R::mndp] << (7 - mn)) & 0b10000000;
-                    MOB{mob[mn]}.output(x, to, mdp, mob_bit, mob_output, mob_presence, mdc, mmc);
-                }
+                u8 hi, lo;
+                if (!(mob[mn].data && MOB{mob[mn]}.shift_out(x, hi, lo))) continue;
+
+                const u8 p = hi | lo;
+                if (!p) continue;
+
+                present[mn] = p;
+                multi |= any & p;
+                any |= p;
+
+                const u64 p_bytes = px_bytes.of[p];
+                if (p_bytes & gfx_fg) mdc |= (0b1 << mn);
+
+                const u8 mdp = (reg[R::mndp] << (7 - mn)) & 0b10000000;
+                const u8* col = mob[mn].col;
+                const auto bcast = [](u8 b) { return Px_bytes::bcast * b; };
+                const u64 p_col = (px_bytes.of[lo & ~hi] & bcast(col[1] | mdp))
+                                    | (px_bytes.of[hi & ~lo] & bcast(col[2] | mdp))
+                                    | (px_bytes.of[hi & lo] & bcast(col[3] | mdp));
+
+                out = (out & ~p_bytes) | p_col;
             }
 
             if (mdc) {
                 if (reg[R::mnd] == 0b00000000) irq.req(IRQ::mdc);
                 reg[R::mnd] |= mdc;
-                mdc = 0b00000000;
             }
 
-            if (mmc) {
-                if (reg[R::mnm] == 0b00000000) irq.req(IRQ::mmc);
-                reg[R::mnm] |= mmc;
-                mmc = 0b00000000;
-            }
+            if (multi) mob_mob_collision(present, multi);
 
-            for (int p = 0; p < 8; ++p) {
-                if (mob_output[p] != MOB::transparent) {
-                    if ((to[p] & mob_output[p] & GFX::foreground) == 0b00000000) {
-                        to[p] = mob_output[p];
-                    }
-                    mob_output[p] = MOB::transparent;
-                    mob_presence[p] = 0b00000000;
-                }
+            if (any) { // mob over gfx, unless behind a fg-gfx pixel
+                const u64 put = px_bytes.of[any] & ~(((gfx & out & fg_bits) >> 7) * 0xff);
+                gfx = (gfx & ~put) | (out & put);
+                std::memcpy(to, &gfx, 8);
             }
         }
 
-        u8 mob_output[8] = {
-            MOB::transparent, MOB::transparent, MOB::transparent, MOB::transparent,
-            MOB::transparent, MOB::transparent, MOB::transparent, MOB::transparent
-        };
-        u8 mob_presence[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-        u8 mdc = 0b00000000; // mob-gfx colliders
-        u8 mmc = 0b00000000; // mob-mob colliders
+        void mob_mob_collision(const u8* present, u8 multi) {
+            u8 mmc = 0b00000000; // mob-mob colliders
+            for (int mn = 0; mn < mob_count; ++mn) if (present[mn] & multi) mmc |= (0b1 << mn);
+
+            if (reg[R::mnm] == 0b00000000) irq.req(IRQ::mmc);
+            reg[R::mnm] |= mmc;
+        }
 
         const Bus& bus;
         u8* reg;
@@ -531,6 +583,11 @@ private:
 
         void output(u8* to);
 
+        static constexpr int batch_max = 40; // cycles
+
+        void upd_gfx_addr();
+        void output_batch(u8* to, const u8* gd_fed, int n, bool px_out);
+
         void output_border(u8* to);
 
         GFX(
@@ -606,18 +663,23 @@ private:
 
         void vb_end() { if (is_on()) s.on_at = 0; }
 
-        void output(u32 upto_pos) {
+        // the changes from 'noted_from' on are noted by the caller (i.e. the current cycle)
+        void output(u32 upto_pos, u32 noted_from = not_set) {
             if (is_on()) {
                 if (going_off()) {
-                    while (s.on_at < s.off_at) vs.frame[s.on_at++] = vs.reg[R::ecol];
+                    if (pixels) fill(s.off_at, noted_from);
                     s.on_at = not_set;
+                } else if (pixels) {
+                    fill(upto_pos, noted_from);
                 } else {
-                    while (s.on_at < upto_pos) vs.frame[s.on_at++] = vs.reg[R::ecol];
+                    s.on_at = std::max(s.on_at, upto_pos);
                 }
             }
         }
 
-        Border(VS& vs_) : vs(vs_), s(vs_.border) {}
+        bool pixels = true; // see 'pixel_output()'
+
+        Border(VS& vs_, Changed_lines& changed_) : vs(vs_), s(vs_.border), changed(changed_) {}
 
     private:
         bool is_on()     const { return s.on_at != not_set; }
@@ -636,8 +698,20 @@ private:
             else if (top() && vs.cr1(CR1::den)) unlock();
         }
 
+        void fill(u32 upto_pos, u32 noted_from) {
+            const u32 from = s.on_at;
+            const u8 col = vs.reg[R::ecol];
+            u8 diff = 0;
+            for (; s.on_at < upto_pos; ++s.on_at) {
+                if (s.on_at < noted_from) diff |= vs.frame[s.on_at] ^ col;
+                vs.frame[s.on_at] = col;
+            }
+            if (diff) changed.at(from, std::min(s.on_at, noted_from));
+        }
+
         VS& vs;
         State& s;
+        Changed_lines& changed;
     };
 
     void check_raster_irq() {
@@ -668,6 +742,66 @@ private:
 
     void output();
 
+    /*  Line batching: in the middle of a line (cycles 18..54), the output gets just recorded,
+        and then rendered in one go (at cycle 55, or at a register write). Only for lines
+        with no sprites, no register writes since cycle 13, and the border either open
+        (and gfx not blocked), or on all the way (or any, if no pixel output).
+    */
+    struct Line_batch {
+        bool enabled = true;
+        bool on = false;
+        bool px_out; // gfx visible (i.e. not under the border)
+        u8 n;
+        u32 pos;
+        u8 gd[GFX::batch_max];
+    };
+
+    void start_batch() {
+        if (s.cycle - w_cycle <= (18 - 13)) return;
+        for (const auto& m : s.mob) if (m.data) return;
+
+        const bool border_off = s.border.on_at == VS::Border::not_set;
+        const bool border_on = !border_off && s.border.off_at == VS::Border::not_set;
+        if (pixels && !(border_on || (border_off && !s.gfx.blocked))) return;
+
+        batch.on = true;
+        batch.px_out = pixels && border_off;
+        batch.n = 0;
+        batch.pos = s.beam_pos;
+    }
+
+    void output_batched() {
+        batch.gd[batch.n++] = s.gfx.gd;
+        gfx.upd_gfx_addr();
+        s.beam_pos += 8;
+    }
+
+    void flush_batch() {
+        if (!batch.on) return;
+        batch.on = false;
+        u8* to = &s.frame[batch.pos];
+        if (batch.px_out) {
+            const int sz = 8 * batch.n;
+            u8 was[8 * GFX::batch_max];
+            std::memcpy(was, to, sz);
+            gfx.output_batch(to, batch.gd, batch.n, true);
+            if (std::memcmp(was, to, sz) != 0) changed.at(batch.pos);
+        } else {
+            gfx.output_batch(to, batch.gd, batch.n, false);
+            border.output(s.beam_pos);
+        }
+    }
+
+    static u64 px8(const u8* px) { u64 p; std::memcpy(&p, px, 8); return p; }
+
+    // the 8 pixels of the cycle done (incl. the border), 'was': as they were before
+    void note_output(u64 was) {
+        const u32 at = s.beam_pos;
+        s.beam_pos += 8;
+        border.output(s.beam_pos, at);
+        if (pixels && px8(&s.frame[at]) != was) changed.at(at);
+    }
+
     VS& s;
 
     const Bus& bus;
@@ -679,6 +813,12 @@ private:
     GFX gfx;
     Border border;
 
+    Line_batch batch;
+    u64 w_cycle = 0;
+
+    bool pixels = true; // see 'pixel_output()'
+    u8 px_discard[8]; // (when no pixels, the gfx/mob output for the collisions goes here)
+
 };
 
 
@@ -691,6 +831,7 @@ void Core<Bus>::reset() {
     s.raster_y = 0;
     s.v_blank = VS::V_blank::vb_on;
     s.beam_pos = 0;
+    batch.on = false;
     for (int r = 0; r < VS::REG_COUNT; ++r) w(r, 0);
 }
 
@@ -819,8 +960,6 @@ void Core<Bus>::GFX::output(u8* to) {
         if (gs.pipeline & 0x0000000001550000) gs.px = gs.pipeline >> 62;
     };
 
-    const u16 c_base = (reg[R::mptr] & MPTR::cg) << 10;
-
     if (gs.blocked) gs.pipeline &= 0x00ffffffffffffff; // flush gd (just the upcoming 8 bits)
 
     switch (gs.mode) {
@@ -829,9 +968,7 @@ void Core<Bus>::GFX::output(u8* to) {
                     ? gs.vmd.col | foreground
                     : reg[R::bgc0]);
             while (shift());
-
-            gs.gfx_addr = c_base | (gs.vm[gs.vmri].data << 3) | gs.rc;
-            return;
+            break;
 
         case mccm:
             if (gs.vmd.col & multicolor) {
@@ -870,18 +1007,14 @@ void Core<Bus>::GFX::output(u8* to) {
                     --shifts;
                 } while (shifts);
             }
-
-            gs.gfx_addr = c_base | (gs.vm[gs.vmri].data << 3) | gs.rc;
-            return;
+            break;
 
         case sbmm:
             do put(gs.pipeline & 0x8000000000000000
                         ? (gs.vmd.data >> 4) | foreground
                         : (gs.vmd.data & 0xf));
             while (shift());
-
-            gs.gfx_addr = (c_base & 0x2000) | (gs.vc << 3) | gs.rc;
-            return;
+            break;
 
         case mcbmm:
             do {
@@ -894,19 +1027,14 @@ void Core<Bus>::GFX::output(u8* to) {
                     case 0b11: put(gs.vmd.col | foreground);          break;
                 }
             } while (shift());
-
-            gs.gfx_addr = (c_base & 0x2000) | (gs.vc << 3) | gs.rc;
-            return;
+            break;
 
         case ecm:
             do put(gs.pipeline & 0x8000000000000000
                         ? gs.vmd.col | foreground
                         : reg[R::bgc0 + (gs.vmd.data >> 6)]);
             while (shift());
-
-            gs.gfx_addr = (c_base | (gs.vm[gs.vmri].data << 3) | gs.rc)
-                                & addr_ecm_mask;
-            return;
+            break;
 
         case icm:
             if (gs.vmd.col & multicolor) {
@@ -938,31 +1066,167 @@ void Core<Bus>::GFX::output(u8* to) {
                     --shifts;
                 } while (shifts);
             }
-
-            gs.gfx_addr = (c_base | (gs.vm[gs.vmri].data << 3) | gs.rc)
-                                & addr_ecm_mask;
-            return;
+            break;
 
         case ibmm1:
             do put((gs.pipeline >> 56) & 0x80); while (shift()); // sets col.0 & fg-gfx flag
-
-            gs.gfx_addr = ((c_base & 0x2000) | (gs.vc << 3) | gs.rc)
-                                & addr_ecm_mask;
-            return;
+            break;
 
         case ibmm2:
             do {
                 latch_2bit_px();
                 put(gs.px << 6); // sets col.0 & fg-gfx flag
             } while (shift());
+            break;
+    }
+
+    upd_gfx_addr();
+}
+
 
-            gs.gfx_addr = ((c_base & 0x2000) | (gs.vc << 3) | gs.rc)
-                                & addr_ecm_mask;
+template<typename Bus>
+void Core<Bus>::GFX::upd_gfx_addr() {
+    const u16 c_base = (reg[R::mptr] & MPTR::cg) << 10;
+
+    switch (gs.mode) {
+        case scm: case mccm:
+            gs.gfx_addr = c_base | (gs.vm[gs.vmri].data << 3) | gs.rc;
+            return;
+        case sbmm: case mcbmm:
+            gs.gfx_addr = (c_base & 0x2000) | (gs.vc << 3) | gs.rc;
+            return;
+        case ecm: case icm:
+            gs.gfx_addr = (c_base | (gs.vm[gs.vmri].data << 3) | gs.rc) & addr_ecm_mask;
+            return;
+        case ibmm1: case ibmm2:
+            gs.gfx_addr = ((c_base & 0x2000) | (gs.vc << 3) | gs.rc) & addr_ecm_mask;
             return;
     }
 }
 
 
+/*  Renders 'n' cycles worth of output in one go, given the gd fed at each of the cycles.
+    The result (incl. the pipeline/vmd/px state) is the same as with 'feed_pipeline()' &
+    'output()' for each cycle, provided nothing (mode, x-scroll, colors) changed during
+    the cycles, nor during the two cycles before (so that the pipeline holds just the
+    two previous gd's, and the vmd-timers).
+    In terms of chars: c[0] shows its last 'xs' pixels, c[1]..c[n-1] all of them, and
+    c[n] the first '8 - xs' pixels, with each vmd taken at the first pixel of the char.
+*/
+template<typename Bus>
+void Core<Bus>::GFX::output_batch(u8* to, const u8* gd_fed, int n, bool px_out) {
+    const int xs = vs.cr2(CR2::x_scroll);
+    const bool vma_started = gs.vmri > 0;
+
+    u8 c[2 + batch_max];
+    c[0] = xs ? u8(gs.pipeline >> (64 - xs)) : 0;
+    c[1] = u8(gs.pipeline >> (56 - xs));
+    std::copy(gd_fed, gd_fed + n, c + 2);
+
+    // c[m] gets the vmd that gets loaded when it reaches the first pixel
+    const int vmd_delay = xs ? 1 : 2;
+    const auto vmd_of = [&](int m) {
+        const int k = m - vmd_delay;
+        return (k < 0 || !vma_started) ? gs.vmd : gs.vm[gs.vmoi + k];
+    };
+
+    // c[m] as 4 colors & a multicolor flag (see 'SIMD::Expand')
+    u32 cols[2 + batch_max] = {};
+    u8 mc[2 + batch_max] = {};
+
+    const auto c4 = [](u32 c0, u32 c1, u32 c2, u32 c3) { return c0 | (c1 << 8) | (c2 << 16) | (c3 << 24); };
+    const auto mc_flag = [](bool on) { return on ? u8(0xff) : u8(0x00); };
+
+    const int m_first = xs ? 0 : 1;
+
+    for (int m = m_first; m <= n; ++m) {
+        const State::VM_data vmd = vmd_of(m);
+
+        switch (gs.mode) {
+            case scm:
+                cols[m] = c4(reg[R::bgc0], 0, 0, vmd.col | foreground);
+                mc[m] = mc_flag(false);
+                break;
+            case mccm:
+                mc[m] = mc_flag(vmd.col & multicolor);
+                cols[m] = mc[m]
+                    ? c4(reg[R::bgc0], reg[R::bgc1] | 0x40, reg[R::bgc2] | 0x80, (vmd.col & 0x7) | 0xc0)
+                    : c4(reg[R::bgc0], 0, 0, vmd.col | foreground);
+                break;
+            case sbmm:
+                cols[m] = c4(vmd.data & 0xf, 0, 0, (vmd.data >> 4) | foreground);
+                mc[m] = mc_flag(false);
+                break;
+            case mcbmm:
+                cols[m] = c4(reg[R::bgc0], vmd.data >> 4, (vmd.data & 0xf) | foreground, vmd.col | foreground);
+                mc[m] = mc_flag(true);
+                break;
+            case ecm:
+                cols[m] = c4(reg[R::bgc0 + (vmd.data >> 6)], 0, 0, vmd.col | foreground);
+                mc[m] = mc_flag(false);
+                break;
+            case icm: // (just col.0 & fg-gfx flag)
+                mc[m] = mc_flag(vmd.col & multicolor);
+                cols[m] = mc[m] ? c4(0x00, 0x40, 0x80, 0xc0) : c4(0x00, 0, 0, 0x80);
+                break;
+            case ibmm1:
+                cols[m] = c4(0x00, 0, 0, 0x80);
+                mc[m] = mc_flag(false);
+                break;
+            case ibmm2:
+                cols[m] = c4(0x00, 0x40, 0x80, 0xc0);
+                mc[m] = mc_flag(true);
+                break;
+        }
+    }
+
+    const auto bit  = [](u8 d, int p) { return (d >> (7 - p)) & 0b1; };
+    const auto pair = [](u8 d, int p) { return (d >> (6 - (p & 0b110))) & 0b11; };
+
+    u8 px = gs.px;
+
+    if (px_out) {
+        // partial chars a pixel at a time, the rest (whole chars) with the SIMD kernel
+        const auto output_part = [&](int m, int first, int last) {
+            for (int p = first; p <= last; ++p) {
+                if (mc[m] && !(p & 0b1)) px = pair(c[m], p); // latched at the even pixels
+                *to++ = cols[m] >> (8 * (mc[m] ? px : bit(c[m], p) * 0b11));
+            }
+        };
+
+        if (xs) output_part(0, 8 - xs, 7);
+
+        const int m_last = xs ? n - 1 : n; // last whole char
+        SIMD::expand(to, c + 1, mc + 1, cols + 1, m_last);
+        to += 8 * m_last;
+        for (int m = m_last; m >= 1; --m) if (mc[m]) { px = pair(c[m], 6); break; }
+
+        if (xs) output_part(n, 0, 7 - xs);
+    } else {
+        for (int m = m_first; m <= n; ++m) {
+            const int first = (m == 0) ? 8 - xs : 0;
+            const int last  = (m == n) ? 7 - xs : 7;
+            const int at = last & 0b110; // the last latch
+            if (mc[m] && at >= first) {
+                // if blocked, the pixels get cleared a cycle at a time, i.e. a pair straddling
+                // the cycles (with an odd 'xs') still gets its 2nd pixel
+                px = !gs.blocked ? pair(c[m], at) : (at == 7 - xs) ? bit(c[m], at + 1) : 0;
+            }
+        }
+    }
+
+    gs.px = px;
+
+    if (vma_started) {
+        gs.vmd = gs.vm[gs.vmoi + n - 1];
+        gs.vmoi += n;
+    }
+
+    const u64 timers = xs ? ((u64(1) << (16 - xs)) | (u64(1) << (24 - xs))) : (u64(1) << 16);
+    gs.pipeline = (u64(c[n + 1]) << (56 - xs)) | (xs ? (u64(c[n]) << (64 - xs)) : 0) | timers;
+}
+
+
 template<typename Bus>
 void Core<Bus>::GFX::output_border(u8* to) {
     const auto put = [&](const u8 c) {
@@ -991,19 +1255,24 @@ void Core<Bus>::GFX::output_border(u8* to) {
 
 template<typename Bus>
 void Core<Bus>::output_border() {
-    gfx.output_border(beam_ptr());
-    mobs.output(s.raster_x(), beam_ptr());
-    s.beam_pos += 8;
-    border.output(s.beam_pos);
+    const u64 was = px8(beam_ptr());
+    if (pixels) {
+        gfx.output_border(beam_ptr());
+        mobs.output(s.raster_x(), beam_ptr());
+    } else {
+        update_mobs(); // (no fg-gfx, i.e. no mob-gfx collisions in the border)
+    }
+    note_output(was);
 }
 
 
 template<typename Bus>
 void Core<Bus>::output() {
-    gfx.output(beam_ptr());
-    mobs.output(s.raster_x(), beam_ptr());
-    s.beam_pos += 8;
-    border.output(s.beam_pos);
+    u8* to = pixels ? beam_ptr() : px_discard;
+    const u64 was = px8(beam_ptr());
+    gfx.output(to);
+    mobs.output(s.raster_x(), to);
+    note_output(was);
 }
 
 
@@ -1084,19 +1353,30 @@ void Core<Bus>::tick() {
             gfx.read_gd();
             gfx.read_vm();
             return;
-        case 18: case 19:
+        case 18:
+            if (batch.enabled) start_batch();
+            // fall through
+        case 19:
         case 20: case 21: case 22: case 23: case 24: case 25: case 26: case 27: case 28: case 29:
         case 30: case 31: case 32: case 33: case 34: case 35: case 36: case 37: case 38: case 39:
         case 40: case 41: case 42: case 43: case 44: case 45: case 46: case 47: case 48: case 49:
         case 50: case 51: case 52: case 53:
-            gfx.feed_pipeline();
-            output();
+            if (batch.on) {
+                output_batched();
+            } else {
+                gfx.feed_pipeline();
+                output();
+            }
             gfx.read_gd();
             gfx.read_vm();
             return;
         case 54:
-            gfx.feed_pipeline();
-            output();
+            if (batch.on) {
+                output_batched();
+            } else {
+                gfx.feed_pipeline();
+                output();
+            }
             gfx.read_gd();
             gfx.ba_done();
             mobs.check_dma_ye();
@@ -1104,6 +1384,7 @@ void Core<Bus>::tick() {
             mobs.prep_dma(0);
             return;
         case 55:
+            flush_batch();
             gfx.feed_pipeline();
             border.check_right(CR2::csel ^ CR2::csel);
             output();
@@ -0,0 +1,231 @@
+#include "vic_ii_simd.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VIC_II_SIMD_X86
+#include <immintrin.h>
+#endif
+
+
+
+using namespace VIC_II::SIMD;
+
+
+static void expand_scalar(u8* to, const u8* gd, const u8* mc, const u32* cols, int n) {
+    for (int c = 0; c < n; ++c) {
+        for (int p = 0; p < 8; ++p) {
+            const int ci = mc[c]
+                ? (gd[c] >> (6 - (p & 0b110))) & 0b11
+                : ((gd[c] >> (7 - p)) & 0b1) * 0b11;
+            *to++ = cols[c] >> (8 * ci);
+        }
+    }
+}
+
+
+static void to_rgb_scalar(u32* to, const u8* px, const u32* palette, int n, int rep) {
+    for (int i = 0; i < n; ++i) {
+        const u32 col = palette[px[i] & 0xf];
+        for (int r = 0; r < rep; ++r) *to++ = col;
+    }
+}
+
+
+#ifdef VIC_II_SIMD_X86
+
+/*  Each pixel (byte) gets the char data masked with its bit(s), then a compare gives the
+    'hi' & 'lo' selectors (in hires chars both from the same bit, i.e. col.0 or col.3).
+    Pixel 0 is in the lowest byte.
+*/
+static constexpr u64 bcast = 0x0101010101010101;
+static constexpr u64 hires_bits = 0x0102040810204080;
+static constexpr u64 mc_hi_bits = 0x0202080820208080;
+static constexpr u64 mc_lo_bits = 0x0101040410104040;
+
+
+__attribute__((target("sse2")))
+static inline __m128i sel_sse2(__m128i m, __m128i a, __m128i b) { // m ? b : a
+    return _mm_or_si128(_mm_andnot_si128(m, a), _mm_and_si128(m, b));
+}
+
+
+__attribute__((target("sse2")))
+static inline __m128i col_sse2(const u32* cols, int ci) { // col.ci of 2 chars, 8 pixels each
+    return _mm_set_epi64x(((cols[1] >> (8 * ci)) & 0xff) * bcast, ((cols[0] >> (8 * ci)) & 0xff) * bcast);
+}
+
+
+__attribute__((target("sse2")))
+static void expand_sse2(u8* to, const u8* gd, const u8* mc, const u32* cols, int n) {
+    const __m128i hires = _mm_set1_epi64x(hires_bits);
+    const __m128i mc_hi = _mm_set1_epi64x(mc_hi_bits);
+    const __m128i mc_lo = _mm_set1_epi64x(mc_lo_bits);
+
+    int c = 0;
+    for (; c + 2 <= n; c += 2, to += 16) {
+        const __m128i d = _mm_set_epi64x(gd[c + 1] * bcast, gd[c] * bcast);
+        const __m128i m = _mm_set_epi64x(mc[c + 1] * bcast, mc[c] * bcast);
+
+        const __m128i hi_bits = sel_sse2(m, hires, mc_hi);
+        const __m128i lo_bits = sel_sse2(m, hires, mc_lo);
+        const __m128i hi = _mm_cmpeq_epi8(_mm_and_si128(d, hi_bits), hi_bits);
+        const __m128i lo = _mm_cmpeq_epi8(_mm_and_si128(d, lo_bits), lo_bits);
+
+        const u32* cc = cols + c;
+        const __m128i px = sel_sse2(hi,
+            sel_sse2(lo, col_sse2(cc, 0), col_sse2(cc, 1)),
+            sel_sse2(lo, col_sse2(cc, 2), col_sse2(cc, 3)));
+
+        _mm_storeu_si128((__m128i*)to, px);
+    }
+
+    expand_scalar(to, gd + c, mc + c, cols + c, n - c);
+}
+
+
+__attribute__((target("avx2")))
+static void expand_avx2(u8* to, const u8* gd, const u8* mc, const u32* cols, int n) {
+    const __m256i hires = _mm256_set1_epi64x(hires_bits);
+    const __m256i mc_hi = _mm256_set1_epi64x(mc_hi_bits);
+    const __m256i mc_lo = _mm256_set1_epi64x(mc_lo_bits);
+
+    // 4 chars at a time: byte shuffles spread the char data (gd/mc: byte 'c', cols: byte
+    // '4c + ci') to its 8 pixels
+    const __m256i char_idx = _mm256_setr_epi8(
+        0, 0, 0, 0, 0, 0, 0, 0,   1, 1, 1, 1, 1, 1, 1, 1,
+        2, 2, 2, 2, 2, 2, 2, 2,   3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i col_idx = _mm256_setr_epi8(
+        0, 0, 0, 0, 0, 0, 0, 0,   4, 4, 4, 4, 4, 4, 4, 4,
+        8, 8, 8, 8, 8, 8, 8, 8,   12, 12, 12, 12, 12, 12, 12, 12);
+
+    int c = 0;
+    for (; c + 4 <= n; c += 4, to += 32) {
+        u32 gd4, mc4;
+        std::memcpy(&gd4, gd + c, 4);
+        std::memcpy(&mc4, mc + c, 4);
+        const __m256i d = _mm256_shuffle_epi8(_mm256_set1_epi32(gd4), char_idx);
+        const __m256i m = _mm256_shuffle_epi8(_mm256_set1_epi32(mc4), char_idx);
+
+        const __m256i hi_bits = _mm256_blendv_epi8(hires, mc_hi, m);
+        const __m256i lo_bits = _mm256_blendv_epi8(hires, mc_lo, m);
+        const __m256i hi = _mm256_cmpeq_epi8(_mm256_and_si256(d, hi_bits), hi_bits);
+        const __m256i lo = _mm256_cmpeq_epi8(_mm256_and_si256(d, lo_bits), lo_bits);
+
+        const __m256i cc = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)(cols + c)));
+        const __m256i col0 = _mm256_shuffle_epi8(cc, col_idx);
+        const __m256i col1 = _mm256_shuffle_epi8(cc, _mm256_add_epi8(col_idx, _mm256_set1_epi8(1)));
+        const __m256i col2 = _mm256_shuffle_epi8(cc, _mm256_add_epi8(col_idx, _mm256_set1_epi8(2)));
+        const __m256i col3 = _mm256_shuffle_epi8(cc, _mm256_add_epi8(col_idx, _mm256_set1_epi8(3)));
+
+        const __m256i px = _mm256_blendv_epi8(
+            _mm256_blendv_epi8(col0, col1, lo),
+            _mm256_blendv_epi8(col2, col3, lo), hi);
+
+        _mm256_storeu_si256((__m256i*)to, px);
+    }
+
+    expand_sse2(to, gd + c, mc + c, cols + c, n - c);
+}
+
+/*  The palette is split into 4 byte planes (16 bytes each), so that a byte shuffle does the
+    lookup for 16 pixels at a time (one plane --> one byte of each color). The planes are
+    then interleaved back to colors.
+*/
+template<int rep>
+__attribute__((target("ssse3")))
+static inline void store_ssse3(u32*& to, __m128i c) { // 4 colors
+    if constexpr (rep == 1) {
+        _mm_storeu_si128((__m128i*)to, c);
+    } else if constexpr (rep == 2) {
+        _mm_storeu_si128((__m128i*)to, _mm_unpacklo_epi32(c, c));
+        _mm_storeu_si128((__m128i*)(to + 4), _mm_unpackhi_epi32(c, c));
+    } else {
+        _mm_storeu_si128((__m128i*)to, _mm_shuffle_epi32(c, _MM_SHUFFLE(1, 0, 0, 0)));
+        _mm_storeu_si128((__m128i*)(to + 4), _mm_shuffle_epi32(c, _MM_SHUFFLE(2, 2, 1, 1)));
+        _mm_storeu_si128((__m128i*)(to + 8), _mm_shuffle_epi32(c, _MM_SHUFFLE(3, 3, 3, 2)));
+    }
+    to += 4 * rep;
+}
+
+
+template<int rep>
+__attribute__((target("ssse3")))
+static void to_rgb_ssse3(u32* to, const u8* px, const u32* palette, int n) {
+    alignas(16) u8 planes[4][16];
+    for (int c = 0; c < 16; ++c) {
+        for (int b = 0; b < 4; ++b) planes[b][c] = palette[c] >> (8 * b);
+    }
+    const __m128i p0 = _mm_load_si128((const __m128i*)planes[0]);
+    const __m128i p1 = _mm_load_si128((const __m128i*)planes[1]);
+    const __m128i p2 = _mm_load_si128((const __m128i*)planes[2]);
+    const __m128i p3 = _mm_load_si128((const __m128i*)planes[3]);
+    const __m128i lo_nibble = _mm_set1_epi8(0x0f);
+
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i idx = _mm_and_si128(_mm_loadu_si128((const __m128i*)(px + i)), lo_nibble);
+
+        const __m128i b0 = _mm_shuffle_epi8(p0, idx);
+        const __m128i b1 = _mm_shuffle_epi8(p1, idx);
+        const __m128i b2 = _mm_shuffle_epi8(p2, idx);
+        const __m128i b3 = _mm_shuffle_epi8(p3, idx);
+
+        const __m128i b01_lo = _mm_unpacklo_epi8(b0, b1);
+        const __m128i b01_hi = _mm_unpackhi_epi8(b0, b1);
+        const __m128i b23_lo = _mm_unpacklo_epi8(b2, b3);
+        const __m128i b23_hi = _mm_unpackhi_epi8(b2, b3);
+
+        store_ssse3<rep>(to, _mm_unpacklo_epi16(b01_lo, b23_lo));
+        store_ssse3<rep>(to, _mm_unpackhi_epi16(b01_lo, b23_lo));
+        store_ssse3<rep>(to, _mm_unpacklo_epi16(b01_hi, b23_hi));
+        store_ssse3<rep>(to, _mm_unpackhi_epi16(b01_hi, b23_hi));
+    }
+
+    to_rgb_scalar(to, px + i, palette, n - i, rep);
+}
+
+
+static void to_rgb_ssse3(u32* to, const u8* px, const u32* palette, int n, int rep) {
+    switch (rep) {
+        case 1:  to_rgb_ssse3<1>(to, px, palette, n); break;
+        case 2:  to_rgb_ssse3<2>(to, px, palette, n); break;
+        default: to_rgb_ssse3<3>(to, px, palette, n); break;
+    }
+}
+
+#endif // VIC_II_SIMD_X86
+
+
+static Expand select() {
+#ifdef VIC_II_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return expand_avx2;
+    if (__builtin_cpu_supports("sse2")) return expand_sse2;
+#endif
+    return expand_scalar;
+}
+
+
+const Expand VIC_II::SIMD::expand = select();
+
+
+static To_rgb select_to_rgb() {
+#ifdef VIC_II_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3")) return to_rgb_ssse3;
+#endif
+    return to_rgb_scalar;
+}
+
+
+const To_rgb VIC_II::SIMD::to_rgb = select_to_rgb();
+
+
+const char* VIC_II::SIMD::backend() {
+#ifdef VIC_II_SIMD_X86
+    if (expand == expand_avx2) return "avx2";
+    if (expand == expand_sse2) return "sse2";
+#endif
+    return "scalar";
+}
@@ -0,0 +1,39 @@
+#ifndef VIC_II_SIMD_H_INCLUDED
+#define VIC_II_SIMD_H_INCLUDED
+
+#include "common.h"
+
+
+
+// Pixel expansion kernels for the VIC-II gfx & output (selected at runtime, based on the CPU
+// features)
+namespace VIC_II {
+
+namespace SIMD {
+
+
+/*  Expands 'n' chars (8 pixels each) at a time. Each char comes with its 4 colors ('cols',
+    little-endian, i.e. col.0 in the lowest byte) and a multicolor flag ('mc', 0 or 0xff):
+        mc:    each bit pair selects a color (00 --> col.0, ..., 11 --> col.3)
+        hires: each bit selects either col.0 (0), or col.3 (1)
+*/
+using Expand = void (*)(u8* to, const u8* gd, const u8* mc, const u32* cols, int n);
+
+extern const Expand expand;
+
+const char* backend(); // 'avx2', 'sse2' or 'scalar'
+
+
+/*  Converts 'n' pixels (palette indices, low nibble) to colors, each one repeated 'rep'
+    (1..3) times (i.e. a frame row to a host texture row)
+*/
+using To_rgb = void (*)(u32* to, const u8* px, const u32* palette, int n, int rep);
+
+extern const To_rgb to_rgb;
+
+
+} // namespace SIMD
+
+} // namespace VIC_II
+
+#endif // VIC_II_SIMD_H_INCLUDED